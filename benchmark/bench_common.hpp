@@ -0,0 +1,60 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#include <vector>
+#include "lithosphere.hpp"
+#include "sqrdmd.hpp"
+
+// All benchmarks use fixed seeds so that results can be compared between
+// commits.
+static const long BENCH_SEED = 3;
+
+/// Number of operator new calls so far, see bench_alloc.cpp.
+uint64_t benchAllocations();
+
+/// Terrain of a square plate: fractal noise where the higher half becomes
+/// continental crust and the rest oceanic crust.
+inline std::vector<float> benchTerrain(uint32_t side, long seed)
+{
+    const uint32_t size = side + 1; // sqrdmd wants 2^n + 1
+    std::vector<float> noise(size * size, 0.0f);
+    sqrdmd(seed, noise.data(), size, 0.7f);
+    normalize(noise.data(), size * size);
+
+    std::vector<float> terrain(side * side);
+    for (uint32_t y = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x) {
+            const float v = noise[y * size + x];
+            terrain[y * side + x] = v > 0.5f ? CONTINENTAL_BASE + v : OCEANIC_BASE;
+        }
+    }
+    return terrain;
+}
+
+/// World with the same parameters the examples and the Python tests use.
+inline lithosphere* benchWorld(uint32_t side)
+{
+    return new lithosphere(BENCH_SEED, side, side, 0.65f, 60, 0.02f,
+                           1000000, 0.33f, 2, 10);
+}
+
+#endif
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include <memory>
+#include "benchmark/benchmark.h"
+#include "bench_common.hpp"
+
+// Number of update() calls timed per world. The count is fixed (instead of
+// letting the framework pick it) so that every run replays the same steps,
+// including the erosion step at iteration 60.
+static const int UPDATE_STEPS = 40;
+
+/// Height map generation (createSlowNoise), sea level search and the
+/// initial split into plates.
+static void BM_LithosphereCreate(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        std::unique_ptr<lithosphere> litho(benchWorld(side));
+        benchmark::DoNotOptimize(litho->getTopography());
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_LithosphereCreate)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
+
+/// createPlates() alone: plate center selection and growPlates().
+static void BM_CreatePlates(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    std::unique_ptr<lithosphere> litho(benchWorld(side));
+    for (auto _ : state) {
+        litho->createPlates();
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_CreatePlates)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
+
+/// One simulation step, averaged over the first UPDATE_STEPS steps of a
+/// freshly created world. Goes up to 4096 because the full-map passes of a
+/// step only outgrow the caches on the largest maps. Also reports the heap
+/// allocations per step.
+static void BM_Update(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    std::unique_ptr<lithosphere> litho(benchWorld(side));
+    const uint64_t before = benchAllocations();
+    for (auto _ : state) {
+        litho->update();
+    }
+    state.counters["allocs"] = benchmark::Counter(
+                                   static_cast<double>(benchAllocations() - before),
+                                   benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_Update)->RangeMultiplier(2)->Range(256, 4096)
+->Iterations(UPDATE_STEPS)->UseRealTime()->Unit(benchmark::kMillisecond);
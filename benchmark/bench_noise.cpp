@@ -0,0 +1,86 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "bench_common.hpp"
+#include "noise.hpp"
+#include "simplexnoise.hpp"
+#include "sqrdmd.hpp"
+
+/// Square-diamond on a (2^n + 1)^2 map.
+static void BM_Sqrdmd(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0)) + 1;
+    std::vector<float> map(size * size);
+    for (auto _ : state) {
+        std::fill(map.begin(), map.end(), 0.0f);
+        sqrdmd(BENCH_SEED, map.data(), size, 0.35f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_Sqrdmd)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
+
+/// Square-diamond with hashed offsets on a (2^n + 1)^2 map, on as many
+/// threads as the machine has cores.
+static void BM_SqrdmdHashed(benchmark::State& state)
+{
+    const int size = static_cast<int>(state.range(0)) + 1;
+    std::vector<float> map(size * size);
+    ThreadPool pool(0);
+    for (auto _ : state) {
+        std::fill(map.begin(), map.end(), 0.0f);
+        sqrdmd_hashed(BENCH_SEED, map.data(), size, 0.35f, &pool);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_SqrdmdHashed)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/// 16 octave simplex noise, as used by createNoise(useSimplex = true).
+static void BM_SimplexNoise(benchmark::State& state)
+{
+    const int side = static_cast<int>(state.range(0));
+    std::vector<float> map(side * side);
+    for (auto _ : state) {
+        simplexnoise(BENCH_SEED, map.data(), side, side, 0.25f);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_SimplexNoise)->RangeMultiplier(2)->Range(128, 1024)
+->Unit(benchmark::kMillisecond);
+
+/// The initial height map of a lithosphere, (side + 1)^2 points.
+static void BM_CreateSlowNoise(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0)) + 1;
+    const WorldDimension dim(side, side);
+    std::vector<float> map(dim.getArea());
+    for (auto _ : state) {
+        createSlowNoise(map.data(), dim, SimpleRandom(BENCH_SEED));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * dim.getArea());
+}
+BENCHMARK(BM_CreateSlowNoise)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
@@ -0,0 +1,182 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include <cstring>
+#include <memory>
+#include <cfloat>
+#include "benchmark/benchmark.h"
+#include "bench_common.hpp"
+#include "erosion.hpp"
+#include "plate.hpp"
+#include "plate_functions.hpp"
+#include "segments.hpp"
+
+static plate* benchPlate(const std::vector<float>& terrain, uint32_t side,
+                         const WorldDimension& world)
+{
+    float* m = new float[side * side]; // Owned by the plate.
+    memcpy(m, terrain.data(), side * side * sizeof(float));
+    return new plate(BENCH_SEED, m, side, side, 0, 0, 1, world);
+}
+
+/// plate::erode on a square plate in a world twice as wide and tall,
+/// routing rivers the given way. Plate construction and destruction are
+/// not timed.
+static void BM_PlateErode(benchmark::State& state, RiverRouting routing)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    const std::vector<float> terrain = benchTerrain(side, BENCH_SEED);
+    const WorldDimension world(2 * side, 2 * side);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<plate> p(benchPlate(terrain, side, world));
+        state.ResumeTiming();
+
+        p->erode(CONTINENTAL_BASE, routing);
+
+        state.PauseTiming();
+        p.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK_CAPTURE(BM_PlateErode, frontier, RIVERS_FRONTIER)
+->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_PlateErode, flood, RIVERS_PRIORITY_FLOOD)
+->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+
+/// plate::smooth, the erosion of ThermalErosion previews, on the same
+/// plates as BM_PlateErode.
+static void BM_PlateSmooth(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    const std::vector<float> terrain = benchTerrain(side, BENCH_SEED);
+    const WorldDimension world(2 * side, 2 * side);
+    const ThermalErosion erosion;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<plate> p(benchPlate(terrain, side, world));
+        state.ResumeTiming();
+
+        erosion.erode(*p, CONTINENTAL_BASE);
+
+        state.PauseTiming();
+        p.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_PlateSmooth)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
+
+/// The crust redistribution pass of plate::erode alone, on a square plate
+/// that doesn't wrap around the world.
+static void BM_RedistributeCrust(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    const std::vector<float> terrain = benchTerrain(side, BENCH_SEED);
+    HeightMap map(side, side);
+    memcpy(map.raw_data(), terrain.data(), side * side * sizeof(float));
+    PaddedMatrix<float> padded;
+    padded.assign(map, false, false, FLT_MAX);
+    HeightMap out(side, side);
+
+    for (auto _ : state) {
+        redistributeCrust(padded, CONTINENTAL_BASE, false, false, out.raw_data());
+        benchmark::DoNotOptimize(out.raw_data());
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_RedistributeCrust)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
+
+/// Segment every continent of a plate the given way, then look up each
+/// continental point as collisions do. Also reports the heap allocations
+/// per iteration.
+static void BM_CreateSegments(benchmark::State& state, Segmentation segmentation)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    const std::vector<float> terrain = benchTerrain(side, BENCH_SEED);
+    const WorldDimension world(2 * side, 2 * side);
+
+    HeightMap map(side, side);
+    memcpy(map.raw_data(), terrain.data(), side * side * sizeof(float));
+    Bounds bounds(world, FloatPoint(0.0f, 0.0f), Dimension(side, side));
+    Segments segments(side * side);
+    MySegmentCreator creator(bounds, &segments, map, world);
+    segments.setSegmentCreator(&creator);
+    segments.setBounds(&bounds);
+
+    uint64_t allocations = 0;
+    for (auto _ : state) {
+        const uint64_t before = benchAllocations();
+        segments.reset();
+        if (segmentation == SEGMENTS_UNION_FIND) {
+            creator.createAllSegments();
+        }
+        for (uint32_t y = 0, i = 0; y < side; ++y) {
+            for (uint32_t x = 0; x < side; ++x, ++i) {
+                if (map[i] >= CONTINENTAL_BASE) {
+                    benchmark::DoNotOptimize(segments.getContinentAt(x, y));
+                }
+            }
+        }
+        allocations += benchAllocations() - before;
+    }
+    state.counters["segments"] = segments.size();
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations),
+                                                  benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK_CAPTURE(BM_CreateSegments, flood, SEGMENTS_LAZY_FLOOD)
+->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CreateSegments, union_find, SEGMENTS_UNION_FIND)
+->RangeMultiplier(2)->Range(256, 2048)->Unit(benchmark::kMillisecond);
+
+/// Crust height and timestamp lookups by world coordinates, as collisions
+/// and subductions do them, on a plate that wraps around both world edges.
+/// Every point of the world is looked up, three in four are outside of the
+/// plate.
+static void BM_PlateCrustLookup(benchmark::State& state)
+{
+    const uint32_t side = static_cast<uint32_t>(state.range(0));
+    const std::vector<float> terrain = benchTerrain(side, BENCH_SEED);
+    const WorldDimension world(2 * side, 2 * side);
+    float* m = new float[side * side]; // Owned by the plate.
+    memcpy(m, terrain.data(), side * side * sizeof(float));
+    plate p(BENCH_SEED, m, side, side, 3 * side / 2, 3 * side / 2, 1, world);
+
+    for (auto _ : state) {
+        float crust = 0;
+        uint32_t timestamp = 0;
+        for (uint32_t y = 0; y < 2 * side; ++y) {
+            for (uint32_t x = 0; x < 2 * side; x += 2) {
+                crust += p.getCrust(x, y);
+                timestamp += p.getCrustTimestamp(x + 1, y);
+            }
+        }
+        benchmark::DoNotOptimize(crust);
+        benchmark::DoNotOptimize(timestamp);
+    }
+    state.SetItemsProcessed(state.iterations() * world.getArea());
+}
+BENCHMARK(BM_PlateCrustLookup)->RangeMultiplier(2)->Range(256, 2048)
+->Unit(benchmark::kMillisecond);
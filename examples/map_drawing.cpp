@@ -4,6 +4,9 @@
 
 using namespace std;
 
+// Resolution of the height thresholds between the colours.
+static const float QUANTILE_PRECISION = 0.00001f;
+
 inline void setGray(png_byte *ptr, int val)
 {
     ptr[0] = val;
@@ -98,26 +101,6 @@ finalise:
     return code;
 }
 
-float find_value_for_quantile(const float quantile, const float* array, const uint32_t size)
-{
-    float value = 0.5;
-    float th_step = 0.5;
-
-    while (th_step > 0.00001)
-    {
-        uint32_t count = 0;
-        for (uint32_t i = 0; i < size; ++i)
-            count += (array[i] < value);
-
-        th_step *= 0.5;
-        if (count / (float)size < quantile)
-            value += th_step;
-        else
-            value -= th_step;
-    }
-    return value;
-}
-
 void gradient(png_byte *ptr, png_byte ra, png_byte ga, png_byte ba, png_byte rb, png_byte gb, png_byte bb, float h, float ha, float hb)
 {
     if (ha>hb) {
@@ -165,12 +148,12 @@ void drawGrayImage(png_structp& png_ptr, png_bytep& row, int width, int height,
 
 void drawColorsImage(png_structp& png_ptr, png_bytep& row, int width, int height, float *heightmap)
 {
-    float q15 = find_value_for_quantile(0.15f, heightmap, width * height);
-    float q70 = find_value_for_quantile(0.70f, heightmap, width * height);
-    float q75 = find_value_for_quantile(0.75f, heightmap, width * height);
-    float q90 = find_value_for_quantile(0.90f, heightmap, width * height);
-    float q95 = find_value_for_quantile(0.95f, heightmap, width * height);
-    float q99 = find_value_for_quantile(0.99f, heightmap, width * height);
+    float q15 = find_value_for_quantile(0.15f, heightmap, width * height, QUANTILE_PRECISION);
+    float q70 = find_value_for_quantile(0.70f, heightmap, width * height, QUANTILE_PRECISION);
+    float q75 = find_value_for_quantile(0.75f, heightmap, width * height, QUANTILE_PRECISION);
+    float q90 = find_value_for_quantile(0.90f, heightmap, width * height, QUANTILE_PRECISION);
+    float q95 = find_value_for_quantile(0.95f, heightmap, width * height, QUANTILE_PRECISION);
+    float q99 = find_value_for_quantile(0.99f, heightmap, width * height, QUANTILE_PRECISION);
 
     int x, y;
     for (y=0 ; y<height ; y++) {
@@ -26,6 +26,9 @@ static PyObject * platec_create(PyObject *self, PyObject *args, PyObject *kwargs
     float aggr_overlap_rel;
     unsigned int cycle_count;
     unsigned int num_plates;
+    unsigned int num_threads = 1;
+    unsigned int erosion_strategy = 0;
+    unsigned int erosion_schedule = 0;
 
     static char *kwlist[] = {
         (char*)"seed",
@@ -38,19 +41,28 @@ static PyObject * platec_create(PyObject *self, PyObject *args, PyObject *kwargs
         (char*)"aggr_overlap_rel",
         (char*)"cycle_count",
         (char*)"num_plates",
+        (char*)"num_threads",
+        (char*)"erosion_strategy",
+        (char*)"erosion_schedule",
         nullptr
     };
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "IIIfIfIfII", kwlist,
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "IIIfIfIfII|III", kwlist,
                                      &seed, &width, &height, &sea_level, &erosion_period,
                                      &folding_ratio, &aggr_overlap_abs, &aggr_overlap_rel,
-                                     &cycle_count, &num_plates))
+                                     &cycle_count, &num_plates, &num_threads,
+                                     &erosion_strategy, &erosion_schedule))
         return nullptr;
     srand(seed);
 
     void *litho = platec_api_create(seed, width, height, sea_level, erosion_period,
                                     folding_ratio, aggr_overlap_abs, aggr_overlap_rel,
-                                    cycle_count, num_plates);
+                                    cycle_count, num_plates, num_threads,
+                                    erosion_strategy, erosion_schedule);
+    if (!litho) {
+        PyErr_SetString(PyExc_ValueError, "unknown erosion strategy or schedule");
+        return nullptr;
+    }
 
     Py_ssize_t pointer = (Py_ssize_t)litho;
     return Py_BuildValue("n", pointer);
@@ -129,6 +141,45 @@ static PyObject * platec_is_finished(PyObject *self, PyObject *args)
     return res;
 }
 
+static PyObject * platec_set_river_routing(PyObject *self, PyObject *args)
+{
+    void *litho;
+    unsigned int routing;
+    if (!PyArg_ParseTuple(args, "nI", &litho, &routing))
+        return nullptr;
+    if (!platec_api_set_river_routing(litho, routing)) {
+        PyErr_SetString(PyExc_ValueError, "unknown river routing");
+        return nullptr;
+    }
+    return Py_BuildValue("i", 0);
+}
+
+static PyObject * platec_set_segmentation(PyObject *self, PyObject *args)
+{
+    void *litho;
+    unsigned int segmentation;
+    if (!PyArg_ParseTuple(args, "nI", &litho, &segmentation))
+        return nullptr;
+    if (!platec_api_set_segmentation(litho, segmentation)) {
+        PyErr_SetString(PyExc_ValueError, "unknown segmentation");
+        return nullptr;
+    }
+    return Py_BuildValue("i", 0);
+}
+
+static PyObject * platec_set_collision_resolution(PyObject *self, PyObject *args)
+{
+    void *litho;
+    unsigned int resolution;
+    if (!PyArg_ParseTuple(args, "nI", &litho, &resolution))
+        return nullptr;
+    if (!platec_api_set_collision_resolution(litho, resolution)) {
+        PyErr_SetString(PyExc_ValueError, "unknown collision resolution");
+        return nullptr;
+    }
+    return Py_BuildValue("i", 0);
+}
+
 static PyMethodDef PlatecMethods[] = {
     {   "create",  (PyCFunction)platec_create, METH_VARARGS | METH_KEYWORDS,
         "Create initial plates configuration."
@@ -148,6 +199,15 @@ static PyMethodDef PlatecMethods[] = {
     {   "is_finished",  platec_is_finished, METH_VARARGS,
         "Is the simulation finished?"
     },
+    {   "set_river_routing",  platec_set_river_routing, METH_VARARGS,
+        "Choose how erosion routes rivers: 0 frontier (default), 1 priority-flood."
+    },
+    {   "set_segmentation",  platec_set_segmentation, METH_VARARGS,
+        "Choose how plates find continents: 0 lazy flood fill (default), 1 union-find."
+    },
+    {   "set_collision_resolution",  platec_set_collision_resolution, METH_VARARGS,
+        "Choose how collisions are handled: 0 per point (default), 1 per continent pair."
+    },
     {nullptr, nullptr, 0, nullptr} /* Sentinel */
 };
 
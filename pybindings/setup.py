@@ -49,12 +49,16 @@ import sys
 
 # Platform-specific compiler flags
 extra_compile_args = []
+extra_link_args = []
 if sys.platform == 'win32':
     # MSVC uses /std:c++17
     extra_compile_args = ['/std:c++17']
 else:
-    # GCC/Clang use -std=c++17
-    extra_compile_args = ['-std=c++17']
+    # GCC/Clang use -std=c++17, plates can be updated on several threads.
+    # Floating point exceptions are never inspected, not trapping on them
+    # lets the erosion and noise kernels be vectorized.
+    extra_compile_args = ['-std=c++17', '-pthread', '-fno-trapping-math']
+    extra_link_args = ['-pthread']
 
 pyplatec = Extension(
     'platec',
@@ -62,7 +66,7 @@ pyplatec = Extension(
     language='c++',
     include_dirs=[cpp_src_dir, 'platec_src'],
     extra_compile_args=extra_compile_args,
-    extra_link_args=[]
+    extra_link_args=extra_link_args
 )
 
 setup (name = 'PyPlatec',
@@ -29,6 +29,17 @@ class TestGeneration(unittest.TestCase):
         )
         platec.destroy(p)
 
+    def test_num_threads_does_not_change_result(self):
+        serial = platec.create(3, 100, 100, 0.65, 60, 0.02, 1000000, 0.33, 2, 10)
+        threaded = platec.create(3, 100, 100, 0.65, 60, 0.02, 1000000, 0.33, 2, 10,
+                                 num_threads=4)
+        for _ in range(50):
+            platec.step(serial)
+            platec.step(threaded)
+        self.assertEqual(platec.get_heightmap(serial), platec.get_heightmap(threaded))
+        platec.destroy(serial)
+        platec.destroy(threaded)
+
     def test_get_heightmap(self):
         seed = 1
         width = 100
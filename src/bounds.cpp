@@ -24,37 +24,12 @@ Bounds::Bounds(const WorldDimension& worldDimension, const FloatPoint& position,
     : _worldDimension(worldDimension),
       _position(position),
       _dimension(dimension) {
+    cacheEdges();
     ASSERT(_dimension.getWidth() <= _worldDimension.getWidth() &&
            _dimension.getHeight() <= _worldDimension.getHeight(),
            "Bounds are larger than the world containing it");
 }
 
-uint32_t Bounds::index(uint32_t x, uint32_t y) const {
-    ASSERT(x < _dimension.getWidth() && y < _dimension.getHeight(),
-           "Invalid coordinates");
-    return y * _dimension.getWidth() + x;
-}
-
-uint32_t Bounds::area() const {
-    return _dimension.getArea();
-}
-
-uint32_t Bounds::width() const {
-    return _dimension.getWidth();
-}
-
-uint32_t Bounds::height() const {
-    return _dimension.getHeight();
-}
-
-uint32_t Bounds::leftAsUint() const {
-    return (uint32_t)_position.getX();
-}
-
-uint32_t Bounds::topAsUint() const {
-    return (uint32_t)_position.getY();
-}
-
 uint32_t Bounds::rightAsUintNonInclusive() const {
     return leftAsUint() + width() - 1;
 }
@@ -78,6 +53,12 @@ bool Bounds::isInLimits(float x, float y) const {
 void Bounds::shift(float dx, float dy) {
     _position.shift(dx, dy, _worldDimension);
     ASSERT(_worldDimension.contains(_position), "Point not in world!");
+    cacheEdges();
+}
+
+void Bounds::cacheEdges() {
+    _left = (uint32_t)_position.getX();
+    _top = (uint32_t)_position.getY();
 }
 
 void Bounds::grow(int dx, int dy) {
@@ -102,11 +83,11 @@ Platec::Rectangle Bounds::asRect() const {
 }
 
 uint32_t Bounds::getMapIndex(uint32_t* px, uint32_t* py) const {
-    return asRect().getMapIndex(px, py);
+    return mapIndex(px, py);
 }
 
 uint32_t Bounds::getValidMapIndex(uint32_t* px, uint32_t* py) const {
-    uint32_t res = asRect().getMapIndex(px, py);
+    uint32_t res = mapIndex(px, py);
     ASSERT(res != BAD_INDEX, "BAD map index found");
     return res;
 }
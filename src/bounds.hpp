@@ -101,7 +101,10 @@ public:
 };
 
 /// Plate bounds.
-class Bounds : public IBounds
+///
+/// Final, so that code holding a Bounds rather than an IBounds calls and
+/// inlines its accessors directly.
+class Bounds final : public IBounds
 {
 public:
 
@@ -112,12 +115,32 @@ public:
            const FloatPoint& position,
            const Dimension& dimension);
 
-    uint32_t index(uint32_t x, uint32_t y) const override;
-    uint32_t area() const override;
-    uint32_t width() const override;
-    uint32_t height() const override;
-    uint32_t leftAsUint() const override;
-    uint32_t topAsUint() const override;
+    uint32_t index(uint32_t x, uint32_t y) const override
+    {
+        ASSERT(x < _dimension.getWidth() && y < _dimension.getHeight(),
+               "Invalid coordinates");
+        return y * _dimension.getWidth() + x;
+    }
+    uint32_t area() const override
+    {
+        return _dimension.getArea();
+    }
+    uint32_t width() const override
+    {
+        return _dimension.getWidth();
+    }
+    uint32_t height() const override
+    {
+        return _dimension.getHeight();
+    }
+    uint32_t leftAsUint() const override
+    {
+        return _left;
+    }
+    uint32_t topAsUint() const override
+    {
+        return _top;
+    }
     uint32_t rightAsUintNonInclusive() const override;
     uint32_t bottomAsUintNonInclusive() const override;
     bool containsWorldPoint(uint32_t x, uint32_t y) const override;
@@ -127,14 +150,40 @@ public:
     uint32_t getValidMapIndex(uint32_t* px, uint32_t* py) const override;
     uint32_t getMapIndex(uint32_t* x, uint32_t* y) const override;
 
+    /// getMapIndex() without the virtual call, for callers holding Bounds.
+    uint32_t mapIndex(uint32_t* px, uint32_t* py) const
+    {
+        // The bounds never wrap more than once around the world: a point
+        // on the world is at most one world width or height past the left
+        // or top edge, so conditional subtractions replace the modulo.
+        const uint32_t world_width = _worldDimension.getWidth();
+        const uint32_t world_height = _worldDimension.getHeight();
+        const uint32_t x = *px < world_width ? *px : *px % world_width;
+        const uint32_t y = *py < world_height ? *py : *py % world_height;
+        const uint32_t lx = x >= _left ? x - _left : x + world_width - _left;
+        const uint32_t ly = y >= _top ? y - _top : y + world_height - _top;
+
+        if (lx >= _dimension.getWidth() || ly >= _dimension.getHeight()) {
+            return BAD_INDEX;
+        }
+        *px = lx;
+        *py = ly;
+        return ly * _dimension.getWidth() + lx;
+    }
+
 private:
 
     /// Return a rectangle representing the Bounds inside the world.
     Platec::Rectangle asRect() const;
 
+    /// Refresh the integer edges after the position changed.
+    void cacheEdges();
+
     const WorldDimension _worldDimension;
     FloatPoint _position;
     Dimension _dimension;
+    uint32_t _left; ///< Integer part of the position's x, in world coordinates.
+    uint32_t _top;  ///< Integer part of the position's y, in world coordinates.
 };
 
 #endif
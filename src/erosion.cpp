@@ -0,0 +1,52 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include "erosion.hpp"
+#include "plate.hpp"
+
+RiverErosion::RiverErosion(RiverRouting routing) : _routing(routing)
+{
+}
+
+void RiverErosion::erode(plate& p, float lower_bound) const
+{
+    p.erode(lower_bound, _routing);
+}
+
+ThermalErosion::ThermalErosion(float talus, float rate) :
+    _talus(talus), _rate(rate)
+{
+}
+
+void ThermalErosion::erode(plate& p, float lower_bound) const
+{
+    p.smooth(lower_bound, _talus, _rate);
+}
+
+IErosion* createErosion(uint32_t strategy)
+{
+    switch (strategy) {
+    case EROSION_RIVERS:
+        return new RiverErosion();
+    case EROSION_THERMAL:
+        return new ThermalErosion();
+    default:
+        return nullptr;
+    }
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#ifndef EROSION_HPP
+#define EROSION_HPP
+
+#include "plate_functions.hpp"
+
+class plate;
+
+/// Built-in erosion strategies, as chosen through platec_api_create().
+enum ErosionStrategy
+{
+    EROSION_RIVERS = 0, ///< RiverErosion, the original erosion.
+    EROSION_THERMAL,    ///< ThermalErosion, a cheap preview.
+    EROSION_STRATEGY_COUNT
+};
+
+/// When lithosphere::update() erodes the plates.
+enum ErosionSchedule
+{
+    EROSION_PERIODIC = 0, ///< Every erosion_period iterations.
+    EROSION_AT_END,       ///< Once at the end of every cycle.
+    EROSION_SCHEDULE_COUNT
+};
+
+/// Erosion applied to the crust of one plate at a time.
+///
+/// The same instance erodes several plates at once on different threads,
+/// so implementations must not change any state of their own.
+class IErosion
+{
+public:
+    virtual ~IErosion() {}
+
+    /// Erode the plate. Crust lower than lower_bound doesn't erode.
+    virtual void erode(plate& p, float lower_bound) const = 0;
+};
+
+/// Rivers flow from every peak and carve their way down, 10 % of noise is
+/// added and crust spreads to lower neighbours: see plate::erode().
+class RiverErosion : public IErosion
+{
+public:
+    explicit RiverErosion(RiverRouting routing = RIVERS_FRONTIER);
+
+    void erode(plate& p, float lower_bound) const override;
+
+    RiverRouting routing() const {
+        return _routing;
+    }
+
+private:
+    const RiverRouting _routing;
+};
+
+/// One pass of thermal erosion, see smoothCrust(). No rivers nor noise:
+/// several times faster than RiverErosion, meant for previews.
+class ThermalErosion : public IErosion
+{
+public:
+    /// @param talus Steepest slope between neighbours that is left alone.
+    /// @param rate  Part of the slope in excess of talus that slides down.
+    explicit ThermalErosion(float talus = 0.1f, float rate = 0.5f);
+
+    void erode(plate& p, float lower_bound) const override;
+
+private:
+    const float _talus;
+    const float _rate;
+};
+
+/// New instance of a built-in strategy, nullptr if strategy is unknown.
+IErosion* createErosion(uint32_t strategy);
+
+#endif
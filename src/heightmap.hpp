@@ -21,14 +21,63 @@
 #define HEIGHTMAP_HPP
 
 #include <stdexcept> // std::invalid_argument
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "utils.hpp"
 #include "rectangle.hpp"
 #include "world_point.hpp"
 
 using namespace std;
 
+/// Storage to allocate for a map of the given area that is growing, with
+/// headroom so that the next growths can reuse it.
+inline uint32_t grownCapacity(uint32_t area)
+{
+    return area + area / 2;
+}
+
+/// Move a width x height block of rows from src to (dx, dy) of a
+/// new_width x new_height block at dest, then set the rest of the new block
+/// to fill. src and dest may be the same storage: rows are moved from the
+/// last one, which never overwrites rows still to be moved as long as the
+/// block only grows.
+template <typename Value>
+void growRows(const Value* src, Value* dest, uint32_t width, uint32_t height,
+              uint32_t new_width, uint32_t new_height,
+              uint32_t dx, uint32_t dy, const Value& fill)
+{
+    static_assert(std::is_trivially_copyable<Value>::value,
+                  "Rows are moved with memmove");
+    ASSERT(dx + width <= new_width && dy + height <= new_height,
+           "The block can only grow");
+
+    if (width == new_width) {
+        // Rows stay contiguous, growing at the bottom moves nothing.
+        if (src != dest || dy > 0) {
+            memmove(dest + dy * new_width, src, width * height * sizeof(Value));
+        }
+    } else {
+        for (uint32_t j = height; j-- > 0;) {
+            memmove(dest + (dy + j) * new_width + dx, src + j * width,
+                    width * sizeof(Value));
+        }
+    }
+
+    std::fill_n(dest, dy * new_width, fill);
+    for (uint32_t j = dy; j < dy + height && width < new_width; ++j) {
+        std::fill_n(dest + j * new_width, dx, fill);
+        std::fill_n(dest + j * new_width + dx + width, new_width - dx - width, fill);
+    }
+    std::fill_n(dest + (dy + height) * new_width,
+                (new_height - dy - height) * new_width, fill);
+}
+
 template <typename Value>
 class Matrix
 {
@@ -39,22 +88,34 @@ public:
     {
         ASSERT(width != 0 && height != 0, "Matrix width and height should be greater than zero");
         _area = width * height;
+        _capacity = _area;
         _data = new Value[_area];
     }
     Matrix(Value* data, unsigned int width, unsigned int height)
         : _width(width), _height(height) {
         ASSERT(data != 0 && width != 0 && height != 0, "Invalid matrix data");
         _area = width * height;
+        _capacity = _area;
         _data = data;
     }
 
     Matrix(const Matrix<Value>& other)
-        : _width(other._width), _height(other._height), _area(other._area)
+        : _width(other._width), _height(other._height), _area(other._area),
+          _capacity(other._area)
     {
         _data = new Value[_area];
         copy(other);
     }
 
+    /// Take over the data of other, which is left empty (zero area).
+    Matrix(Matrix<Value>&& other) noexcept
+        : _data(other._data), _width(other._width), _height(other._height),
+          _area(other._area), _capacity(other._capacity)
+    {
+        other._data = nullptr;
+        other._width = other._height = other._area = other._capacity = 0;
+    }
+
     ~Matrix()
     {
         delete[] _data;
@@ -62,26 +123,63 @@ public:
 
     void set_all(const Value& value)
     {
-        // we cannot use memset to make it very general
-        const uint32_t my_area = area();
-        for (uint32_t i = 0; i < my_area; i++) {
-            _data[i] = value;
+        // Plain data whose bytes are all alike (0, 0xFFFFFFFF...) can be
+        // memset, anything else is left to fill_n, which the compiler
+        // vectorizes for plain data.
+        if constexpr (std::is_trivially_copyable<Value>::value) {
+            if (has_uniform_bytes(value)) {
+                memset(_data, *reinterpret_cast<const unsigned char*>(&value),
+                       _area * sizeof(Value));
+                return;
+            }
         }
+        std::fill_n(_data, _area, value);
     }
     void copy(const Matrix& other)
     {
-        if (_area != other._area) {
-            _width = other._width;
-            _height = other._height;
-            _area = other._area;
+        if (this == &other) {
+            return;
+        }
+        if (other._area > _capacity) {
             delete[] _data;
-            _data = new Value[_area];
+            _data = new Value[other._area];
+            _capacity = other._area;
         }
-        for (uint32_t i = 0; i < _area; i++) {
-            _data[i] = other._data[i];
+        _width = other._width;
+        _height = other._height;
+        _area = other._area;
+        if constexpr (std::is_trivially_copyable<Value>::value) {
+            memcpy(_data, other._data, _area * sizeof(Value));
+        } else {
+            std::copy(other._data, other._data + _area, _data);
         }
     }
 
+    /// Enlarge the matrix to width x height, moving the current content by
+    /// (dx, dy) and setting the new elements to fill.
+    ///
+    /// The current storage is reused when it is large enough, otherwise
+    /// storage with headroom is allocated, so that a matrix growing often
+    /// by small steps is seldom reallocated.
+    void grow(unsigned int width, unsigned int height,
+              unsigned int dx, unsigned int dy, const Value& fill)
+    {
+        const unsigned int area = width * height;
+        if (area > _capacity) {
+            const unsigned int capacity = grownCapacity(area);
+            Value* data = new Value[capacity];
+            growRows(_data, data, _width, _height, width, height, dx, dy, fill);
+            delete[] _data;
+            _data = data;
+            _capacity = capacity;
+        } else {
+            growRows(_data, _data, _width, _height, width, height, dx, dy, fill);
+        }
+        _width = width;
+        _height = height;
+        _area = area;
+    }
+
     inline const Value& set(unsigned int x, unsigned y, const Value& value)
     {
         ASSERT(x < _width && y < _height, "Invalid coordinates");
@@ -101,6 +199,17 @@ public:
         return *this;
     }
 
+    /// Swap in the data of other instead of copying it.
+    Matrix<Value>& operator=(Matrix<Value>&& other) noexcept
+    {
+        std::swap(_data, other._data);
+        std::swap(_width, other._width);
+        std::swap(_height, other._height);
+        std::swap(_area, other._area);
+        std::swap(_capacity, other._capacity);
+        return *this;
+    }
+
     Value& operator[](unsigned int index)
     {
         return this->_data[index];
@@ -129,10 +238,111 @@ public:
     }
 private:
 
+    static bool has_uniform_bytes(const Value& value)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 1; i < sizeof(Value); ++i) {
+            if (bytes[i] != bytes[0]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     Value* _data;
     unsigned int _width;
     unsigned int _height;
     unsigned int _area;
+    unsigned int _capacity; ///< Number of elements _data can hold.
+};
+
+/// Copy of a Matrix surrounded by a border (halo) one element wide, with
+/// rows padded so that each of them starts on a cache line.
+///
+/// Every element, including the ones on the edges, has its four neighbours
+/// at x - 1, x + 1, row(y - 1) and row(y + 1): along an axis that wraps
+/// around the halo repeats the opposite edge, otherwise it holds a fixed
+/// border value. Lookups thus need no bounds checks, masks or modulo.
+template <typename Value>
+class PaddedMatrix
+{
+public:
+    static const uint32_t ALIGNMENT = 64 / sizeof(Value); ///< In elements.
+
+    PaddedMatrix() : _width(0), _height(0), _stride(0), _data(nullptr) {}
+
+    PaddedMatrix(const PaddedMatrix&) = delete;
+    PaddedMatrix& operator=(const PaddedMatrix&) = delete;
+
+    /// Copy source and fill the halo. Storage is reused between calls.
+    ///
+    /// @param wrap_x  Left and right edges are neighbours of each other.
+    /// @param wrap_y  Top and bottom edges are neighbours of each other.
+    /// @param border  Halo value along the axes that do not wrap.
+    void assign(const Matrix<Value>& source, bool wrap_x, bool wrap_y,
+                const Value& border)
+    {
+        _width = source.width();
+        _height = source.height();
+        // One aligned block in front of each row holds its left halo, so
+        // that element 0 is aligned, then the row and its right halo.
+        _stride = (ALIGNMENT + _width + 1 + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+        const size_t size = static_cast<size_t>(_stride) * (_height + 2);
+        if (_storage.size() < size + ALIGNMENT) {
+            _storage.resize(size + ALIGNMENT);
+        }
+        const uintptr_t address = reinterpret_cast<uintptr_t>(_storage.data());
+        const uintptr_t misalignment = address % (ALIGNMENT * sizeof(Value));
+        _data = _storage.data() +
+                (misalignment ? ALIGNMENT - misalignment / sizeof(Value) : 0);
+
+        const Value* src = source.raw_data();
+        for (uint32_t y = 0; y < _height; ++y, src += _width) {
+            Value* dest = row(y);
+            memcpy(dest, src, _width * sizeof(Value));
+            dest[-1] = wrap_x ? src[_width - 1] : border;
+            dest[_width] = wrap_x ? src[0] : border;
+        }
+
+        if (wrap_y) {
+            memcpy(row(-1) - 1, row(_height - 1) - 1, (_width + 2) * sizeof(Value));
+            memcpy(row(_height) - 1, row(0) - 1, (_width + 2) * sizeof(Value));
+        } else {
+            std::fill_n(row(-1) - 1, _width + 2, border);
+            std::fill_n(row(_height) - 1, _width + 2, border);
+        }
+    }
+
+    /// First element of row y, for y from -1 (top halo) to height (bottom
+    /// halo). Elements -1 and width of the row are its halo.
+    Value* row(int y)
+    {
+        return _data + static_cast<ptrdiff_t>(y + 1) * _stride + ALIGNMENT;
+    }
+    const Value* row(int y) const
+    {
+        return _data + static_cast<ptrdiff_t>(y + 1) * _stride + ALIGNMENT;
+    }
+
+    uint32_t width() const
+    {
+        return _width;
+    }
+    uint32_t height() const
+    {
+        return _height;
+    }
+    uint32_t stride() const ///< Distance between rows in elements.
+    {
+        return _stride;
+    }
+private:
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _stride;
+    std::vector<Value> _storage;
+    Value* _data; ///< First aligned element of _storage.
 };
 
 typedef Matrix<float> HeightMap;
@@ -19,10 +19,12 @@
 
 #include "lithosphere.hpp"
 #include "plate.hpp"
+#include "plate_collisions.hpp"
 #include "sqrdmd.hpp"
 #include "simplexnoise.hpp"
 #include "noise.hpp"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstdio>
@@ -50,6 +52,20 @@ uint32_t findBound(const uint32_t* map, uint32_t length, uint32_t x0, uint32_t y
                    int dx, int dy);
 uint32_t findPlate(plate** plates, float x, float y, uint32_t num_plates);
 
+/// Tell whether p is in the span of len points from start, on an axis of
+/// the given length that wraps around.
+static inline bool inWrappedSpan(uint32_t p, uint32_t start, uint32_t len, uint32_t axis)
+{
+    return len >= axis || (p + axis - start % axis) % axis < len;
+}
+
+/// Tell whether two spans on an axis that wraps around share a point.
+static inline bool wrappedSpansOverlap(uint32_t a, uint32_t a_len,
+                                       uint32_t b, uint32_t b_len, uint32_t axis)
+{
+    return inWrappedSpan(b % axis, a, a_len, axis) || inWrappedSpan(a % axis, b, b_len, axis);
+}
+
 WorldPoint lithosphere::randomPosition()
 {
     return WorldPoint(
@@ -65,12 +81,13 @@ void lithosphere::createNoise(float* tmp, const WorldDimension& tmpDim, bool use
 
 void lithosphere::createSlowNoise(float* tmp, const WorldDimension& tmpDim)
 {
-    ::createSlowNoise(tmp, tmpDim, _randsource);
+    ::createSlowNoise(tmp, tmpDim, _randsource, &_threadPool);
 }
 
 lithosphere::lithosphere(long seed, uint32_t width, uint32_t height, float sea_level,
                          uint32_t _erosion_period, float _folding_ratio, uint32_t aggr_ratio_abs,
-                         float aggr_ratio_rel, uint32_t num_cycles, uint32_t _max_plates) noexcept(false) :
+                         float aggr_ratio_rel, uint32_t num_cycles, uint32_t _max_plates,
+                         uint32_t num_threads) noexcept(false) :
     hmap(width, height),
     imap(width, height),
     prev_imap(width, height),
@@ -87,9 +104,16 @@ lithosphere::lithosphere(long seed, uint32_t width, uint32_t height, float sea_l
     max_cycles(num_cycles),
     max_plates(_max_plates),
     num_plates(0),
+    erosion(new RiverErosion()),
+    erosion_schedule(EROSION_PERIODIC),
+    segmentation(SEGMENTS_LAZY_FLOOD),
+    collision_resolution(COLLISIONS_PER_POINT),
+    collisions(new plateCollisions()),
+    subductions(new plateCollisions()),
     _worldDimension(width, height),
     _randsource(seed),
-    _steps(0)
+    _steps(0),
+    _threadPool(num_threads)
 {
     if (width < 5 || height < 5) {
         throw runtime_error("Width and height should be >=5");
@@ -111,25 +135,9 @@ lithosphere::lithosphere(long seed, uint32_t width, uint32_t height, float sea_l
     for (uint32_t i = 0; i < A; ++i) // Scale to [0 ... 1]
         tmp[i] = (tmp[i] - lowest) / (highest - lowest);
 
-    float sea_threshold = 0.5;
-    float th_step = 0.5;
-
     // Find the actual value in height map that produces the continent-sea
     // ratio defined be "sea_level".
-    while (th_step > 0.01)
-    {
-        uint32_t count = 0;
-        for (uint32_t i = 0; i < A; ++i)
-            count += (tmp[i] < sea_threshold);
-
-        th_step *= 0.5;
-        if (count / (float)A < sea_level)
-            sea_threshold += th_step;
-        else
-            sea_threshold -= th_step;
-    }
-
-    sea_level = sea_threshold;
+    sea_level = find_value_for_quantile(sea_level, tmp, A, 0.01f);
     for (uint32_t i = 0; i < A; ++i) // Genesis 1:9-10.
     {
         tmp[i] = (tmp[i] > sea_level) *
@@ -147,9 +155,6 @@ lithosphere::lithosphere(long seed, uint32_t width, uint32_t height, float sea_l
 
     delete[] tmp;
 
-    collisions.resize(max_plates);
-    subductions.resize(max_plates);
-
     // Create default plates
     plates = new plate*[max_plates];
     for (uint32_t i = 0; i < max_plates; i++) {
@@ -165,6 +170,33 @@ lithosphere::~lithosphere() throw()
     plates = 0;
 }
 
+void lithosphere::setRiverRouting(RiverRouting routing)
+{
+    setErosion(new RiverErosion(routing));
+}
+
+RiverRouting lithosphere::getRiverRouting() const noexcept
+{
+    const RiverErosion* rivers = dynamic_cast<const RiverErosion*>(erosion.get());
+    return rivers ? rivers->routing() : RIVERS_FRONTIER;
+}
+
+void lithosphere::setErosion(IErosion* _erosion)
+{
+    if (!_erosion) {
+        throw invalid_argument("Erosion must not be null");
+    }
+    erosion.reset(_erosion);
+}
+
+void lithosphere::erodePlates()
+{
+    _threadPool.parallelFor(num_plates, [this](uint32_t i)
+    {
+        erosion->erode(*plates[i], CONTINENTAL_BASE);
+    });
+}
+
 void lithosphere::clearPlates() {
     for (uint32_t i = 0; i < num_plates; i++) {
         delete plates[i];
@@ -260,6 +292,7 @@ void lithosphere::createPlates()
 {
     try {
         const uint32_t map_area = _worldDimension.getArea();
+        clearPlates();
         num_plates = max_plates;
 
         // Initialize "Free plate center position" lookup table.
@@ -366,16 +399,16 @@ void lithosphere::resolveJuxtapositions(const uint32_t& i, const uint32_t& j, co
 
     // Record collisions to both plates. This also creates
     // continent segment at the collided location to plates.
-    uint32_t this_area = plates[i]->addCollision(x_mod, y_mod);
-    uint32_t prev_area = plates[imap[k]]->addCollision(x_mod, y_mod);
+    ContinentId this_continent, prev_continent;
+    uint32_t this_area = plates[i]->addCollision(x_mod, y_mod, &this_continent);
+    uint32_t prev_area = plates[imap[k]]->addCollision(x_mod, y_mod, &prev_continent);
 
     if (this_area < prev_area)
     {
-        plateCollision coll(imap[k], x_mod, y_mod,
-                            this_map[j] * folding_ratio);
+        const float crust = this_map[j] * folding_ratio;
 
         // Give some...
-        hmap[k] += coll.crust;
+        hmap[k] += crust;
         plates[imap[k]]->setCrust(x_mod, y_mod, hmap[k],
                                   this_age[j]);
 
@@ -384,21 +417,22 @@ void lithosphere::resolveJuxtapositions(const uint32_t& i, const uint32_t& j, co
                             (1.0f - folding_ratio), this_age[j]);
 
         // Add collision to the earlier plate's list.
-        collisions[i].push_back(coll);
+        collisions->add(i, imap[k], x_mod, y_mod, crust,
+                       this_continent, prev_continent);
         ++continental_collisions;
     }
     else
     {
-        plateCollision coll(i, x_mod, y_mod,
-                            hmap[k] * folding_ratio);
+        const float crust = hmap[k] * folding_ratio;
 
         plates[i]->setCrust(x_mod, y_mod,
-                            this_map[j]+coll.crust, amap[k]);
+                            this_map[j]+crust, amap[k]);
 
         plates[imap[k]]->setCrust(x_mod, y_mod, hmap[k]
                                   * (1.0f - folding_ratio), amap[k]);
 
-        collisions[imap[k]].push_back(coll);
+        collisions->add(imap[k], i, x_mod, y_mod, crust,
+                       prev_continent, this_continent);
         ++continental_collisions;
 
         // Give the location to the larger plate.
@@ -413,179 +447,400 @@ void lithosphere::resolveJuxtapositions(const uint32_t& i, const uint32_t& j, co
 // Each plate's map's memory area is accessed sequentially and only
 // once as opposed to calculating "num_plates" indices within plate
 // maps in order to find out which plate(s) own current location.
+//
+// The work is done in two stages. First the world is cut into bands of
+// rows that are composited in parallel: every location gets its first
+// plate (in plate order) as owner and every later plate having crust
+// there is only recorded. Resolving such an overlap touches nothing but
+// the overlapped location, yet it updates plates and the collision
+// lists, so the recorded overlaps are then replayed serially in the
+// exact order a single plate by plate pass would have met them.
 void lithosphere::updateHeightAndPlateIndexMaps(const uint32_t& map_area,
         uint32_t& oceanic_collisions,
         uint32_t& continental_collisions)
 {
-    uint32_t world_width = _worldDimension.getWidth();
-    uint32_t world_height = _worldDimension.getHeight();
-    hmap.set_all(0);
-    imap.set_all(0xFFFFFFFF);
+    const uint32_t world_width = _worldDimension.getWidth();
+    const uint32_t world_height = _worldDimension.getHeight();
+    const uint32_t num_bands = min(_threadPool.size(), world_height);
+
+    // Broad phase: a location can only be owned already where a plate's
+    // bounds overlap those of a plate composited before it.
+    earlier_overlaps.resize(num_plates);
     for (uint32_t i = 0; i < num_plates; ++i)
     {
-        const uint32_t x0 = plates[i]->getLeftAsUint();
-        const uint32_t y0 = plates[i]->getTopAsUint();
-        const uint32_t x1 = x0 + plates[i]->getWidth();
-        const uint32_t y1 = y0 + plates[i]->getHeight();
+        earlier_overlaps[i].clear();
+        for (uint32_t j = 0; j < i; ++j)
+        {
+            if (wrappedSpansOverlap(plates[i]->getLeftAsUint(), plates[i]->getWidth(),
+                                    plates[j]->getLeftAsUint(), plates[j]->getWidth(),
+                                    world_width) &&
+                    wrappedSpansOverlap(plates[i]->getTopAsUint(), plates[i]->getHeight(),
+                                        plates[j]->getTopAsUint(), plates[j]->getHeight(),
+                                        world_height))
+            {
+                earlier_overlaps[i].push_back(j);
+            }
+        }
+    }
 
-        const float*  this_map;
-        const uint32_t* this_age;
-        plates[i]->getMap(&this_map, &this_age);
+    overlap_bands.resize(num_bands);
+    _threadPool.parallelFor(num_bands, [this, world_width, world_height,
+                                        num_bands](uint32_t band)
+    {
+        const uint32_t band_top = band * world_height / num_bands;
+        const uint32_t band_btm = (band + 1) * world_height / num_bands;
+        vector<plateOverlap>& overlaps = overlap_bands[band];
+        overlaps.clear();
+        vector<pair<uint32_t, uint32_t> > contested; // Columns [first, second[.
 
-        uint32_t x_mod_start = (x0 + world_width) % world_width;
-        uint32_t y_mod = (y0 + world_height) % world_height;
+        for (uint32_t y = band_top; y < band_btm; ++y)
+        {
+            const uint32_t y_width = y * world_width;
+            fill(&hmap[y_width], &hmap[y_width] + world_width, 0.0f);
+            fill(&imap[y_width], &imap[y_width] + world_width, 0xFFFFFFFF);
+        }
 
-        // Copy first part of plate onto world map.
-        // MK: These loops are ugly, but using modulus in here is a hog
-        for (uint32_t y = y0, j = 0; y < y1; ++y,
-                y_mod = ++y_mod >= world_height ? y_mod - world_height : y_mod)
+        for (uint32_t i = 0; i < num_plates; ++i)
         {
-            const uint32_t y_width = y_mod * world_width;
-            uint32_t x_mod = x_mod_start;
+            const uint32_t x0 = plates[i]->getLeftAsUint();
+            const uint32_t y0 = plates[i]->getTopAsUint();
+            const uint32_t w = plates[i]->getWidth();
+            const uint32_t h = plates[i]->getHeight();
 
-            for (uint32_t x = x0; x < x1; ++x, ++j,
-                    x_mod = ++x_mod >= world_width ? x_mod - world_width : x_mod)
-            {
-                const uint32_t k = x_mod + y_width;
+            const float*  this_map;
+            const uint32_t* this_age;
+            plates[i]->getMap(&this_map, &this_age);
 
-                if (this_map[j] < 2 * FLT_EPSILON) // No crust here...
+            const uint32_t x_mod_start = (x0 + world_width) % world_width;
+            uint32_t y_mod = (y0 + world_height) % world_height;
+
+            // MK: These loops are ugly, but using modulus in here is a hog
+            for (uint32_t r = 0; r < h; ++r,
+                    y_mod = ++y_mod >= world_height ? y_mod - world_height : y_mod)
+            {
+                if (y_mod < band_top || y_mod >= band_btm)
                     continue;
 
-                if (imap[k] >= num_plates) // No one here yet?
+                const uint32_t y_width = y_mod * world_width;
+
+                // Columns of this row inside the bounds of an earlier plate.
+                contested.clear();
+                for (uint32_t other : earlier_overlaps[i])
                 {
-                    // This plate becomes the "owner" of current location
-                    // if it is the first plate to have crust on it.
-                    hmap[k] = this_map[j];
-                    imap[k] = i;
-                    amap[k] = this_age[j];
+                    if (!inWrappedSpan(y_mod, plates[other]->getTopAsUint(),
+                                       plates[other]->getHeight(), world_height))
+                        continue;
 
-                    continue;
+                    const uint32_t other_w = plates[other]->getWidth();
+                    if (other_w >= world_width)
+                    {
+                        contested.push_back(make_pair(0u, w));
+                        continue;
+                    }
+                    // The other plate starts "offset" columns after this
+                    // one, and again every world_width columns.
+                    const uint32_t offset = (plates[other]->getLeftAsUint() +
+                                             world_width - x_mod_start) % world_width;
+                    for (int64_t first = (int64_t)offset - world_width;
+                            first < (int64_t)w; first += world_width)
+                    {
+                        const int64_t last = first + other_w;
+                        if (last > 0)
+                            contested.push_back(make_pair((uint32_t)max<int64_t>(first, 0),
+                                                          (uint32_t)min<int64_t>(last, w)));
+                    }
                 }
+                sort(contested.begin(), contested.end());
+
+                // Alternate between the free columns before each contested
+                // span and the span itself.
+                uint32_t c = 0;
+                for (size_t s = 0; s <= contested.size(); ++s)
+                {
+                    const uint32_t free_end = s < contested.size() ?
+                                              max(c, contested[s].first) : w;
+                    uint32_t x_mod = (x_mod_start + c) % world_width;
+
+                    // No earlier plate can be here: this one is the owner
+                    // wherever it has crust.
+                    for (uint32_t j = r * w + c, j_end = r * w + free_end; j < j_end; ++j,
+                            x_mod = ++x_mod >= world_width ? x_mod - world_width : x_mod)
+                    {
+                        const uint32_t k = x_mod + y_width;
+
+                        if (this_map[j] < 2 * FLT_EPSILON) // No crust here...
+                            continue;
 
-                // DO NOT ACCEPT HEIGHT EQUALITY! Equality leads to subduction
-                // of shore that 's barely above sea level. It's a lot less
-                // serious problem to treat very shallow waters as continent...
-                const bool prev_is_oceanic = hmap[k] < CONTINENTAL_BASE;
-                const bool this_is_oceanic = this_map[j] < CONTINENTAL_BASE;
-
-                const uint32_t prev_timestamp = plates[imap[k]]->
-                                                getCrustTimestamp(x_mod, y_mod);
-                const uint32_t this_timestamp = this_age[j];
-                const bool prev_is_buoyant = (hmap[k] > this_map[j]) ||
-                                             ((hmap[k] + 2 * FLT_EPSILON > this_map[j]) &&
-                                              (hmap[k] < 2 * FLT_EPSILON + this_map[j]) &&
-                                              (prev_timestamp >= this_timestamp));
-
-                // Handle subduction of oceanic crust as special case.
-                if (this_is_oceanic && prev_is_buoyant) {
-                    // This plate will be the subducting one.
-                    // The level of effect that subduction has
-                    // is directly related to the amount of water
-                    // on top of the subducting plate.
-                    const float sediment = SUBDUCT_RATIO * OCEANIC_BASE *
-                                           (CONTINENTAL_BASE - this_map[j]) /
-                                           CONTINENTAL_BASE;
-
-                    // Save collision to the receiving plate's list.
-                    plateCollision coll(i, x_mod, y_mod, sediment);
-                    subductions[imap[k]].push_back(coll);
-                    ++oceanic_collisions;
-
-                    // Remove subducted oceanic lithosphere from plate.
-                    // This is crucial for
-                    // a) having correct amount of colliding crust (below)
-                    // b) protecting subducted locations from receiving
-                    //    crust from other subductions/collisions.
-                    plates[i]->setCrust(x_mod, y_mod, this_map[j] -
-                                        OCEANIC_BASE, this_timestamp);
-
-                    if (this_map[j] <= 0)
-                        continue; // Nothing more to collide.
-                } else if (prev_is_oceanic) {
-                    const float sediment = SUBDUCT_RATIO * OCEANIC_BASE *
-                                           (CONTINENTAL_BASE - hmap[k]) /
-                                           CONTINENTAL_BASE;
-
-                    plateCollision coll(imap[k], x_mod, y_mod, sediment);
-                    subductions[i].push_back(coll);
-                    ++oceanic_collisions;
-
-                    plates[imap[k]]->setCrust(x_mod, y_mod, hmap[k] -
-                                              OCEANIC_BASE, prev_timestamp);
-                    hmap[k] -= OCEANIC_BASE;
-
-                    if (hmap[k] <= 0) {
-                        imap[k] = i;
                         hmap[k] = this_map[j];
+                        imap[k] = i;
                         amap[k] = this_age[j];
+                    }
+                    c = free_end;
+                    if (s == contested.size())
+                        break;
 
-                        continue;
+                    // Overlapping spans are merged as they are walked.
+                    uint32_t span_end = max(c, contested[s].second);
+                    while (s + 1 < contested.size() && contested[s + 1].first <= span_end)
+                        span_end = max(span_end, contested[++s].second);
+
+                    for (uint32_t j = r * w + c, j_end = r * w + span_end; j < j_end; ++j,
+                            x_mod = ++x_mod >= world_width ? x_mod - world_width : x_mod)
+                    {
+                        const uint32_t k = x_mod + y_width;
+
+                        if (this_map[j] < 2 * FLT_EPSILON) // No crust here...
+                            continue;
+
+                        if (imap[k] >= num_plates) // No one here yet?
+                        {
+                            // This plate becomes the "owner" of current location
+                            // if it is the first plate to have crust on it.
+                            hmap[k] = this_map[j];
+                            imap[k] = i;
+                            amap[k] = this_age[j];
+
+                            continue;
+                        }
+
+                        overlaps.push_back(plateOverlap(i, j, k));
                     }
+                    c = span_end;
                 }
+            }
+        }
+    });
 
-                resolveJuxtapositions(i, j, k, x_mod, y_mod,
-                                      this_map, this_age, continental_collisions);
+    // Each band lists its overlaps in plate order already, only the bands
+    // themselves need to be interleaved.
+    vector<plateOverlap>& overlaps = overlap_bands[0];
+    for (uint32_t band = 1; band < num_bands; ++band)
+    {
+        overlaps.insert(overlaps.end(), overlap_bands[band].begin(),
+                        overlap_bands[band].end());
+    }
+    if (num_bands > 1)
+    {
+        sort(overlaps.begin(), overlaps.end(),
+        [](const plateOverlap& a, const plateOverlap& b) {
+            return a.plate < b.plate ||
+                   (a.plate == b.plate && a.index < b.index);
+        });
+    }
+
+    for (const plateOverlap& overlap : overlaps)
+    {
+        const uint32_t i = overlap.plate;
+        const uint32_t j = overlap.index;
+        const uint32_t k = overlap.world_index;
+        const uint32_t x_mod = k % world_width;
+        const uint32_t y_mod = k / world_width;
+
+        const float*  this_map;
+        const uint32_t* this_age;
+        plates[i]->getMap(&this_map, &this_age);
+
+        // DO NOT ACCEPT HEIGHT EQUALITY! Equality leads to subduction
+        // of shore that 's barely above sea level. It's a lot less
+        // serious problem to treat very shallow waters as continent...
+        const bool prev_is_oceanic = hmap[k] < CONTINENTAL_BASE;
+        const bool this_is_oceanic = this_map[j] < CONTINENTAL_BASE;
+
+        // The owner's crust timestamp is only looked up when it's needed:
+        // to break a tie in height or to subduct the owner's crust.
+        const uint32_t this_timestamp = this_age[j];
+        const bool prev_is_buoyant = (hmap[k] > this_map[j]) ||
+                                     ((hmap[k] + 2 * FLT_EPSILON > this_map[j]) &&
+                                      (hmap[k] < 2 * FLT_EPSILON + this_map[j]) &&
+                                      (plates[imap[k]]->getCrustTimestamp(x_mod, y_mod) >=
+                                       this_timestamp));
+
+        // Handle subduction of oceanic crust as special case.
+        if (this_is_oceanic && prev_is_buoyant) {
+            // This plate will be the subducting one.
+            // The level of effect that subduction has
+            // is directly related to the amount of water
+            // on top of the subducting plate.
+            const float sediment = SUBDUCT_RATIO * OCEANIC_BASE *
+                                   (CONTINENTAL_BASE - this_map[j]) /
+                                   CONTINENTAL_BASE;
+
+            // Save collision to the receiving plate's list.
+            subductions->add(imap[k], i, x_mod, y_mod, sediment);
+            ++oceanic_collisions;
+
+            // Remove subducted oceanic lithosphere from plate.
+            // This is crucial for
+            // a) having correct amount of colliding crust (below)
+            // b) protecting subducted locations from receiving
+            //    crust from other subductions/collisions->
+            plates[i]->setCrust(x_mod, y_mod, this_map[j] -
+                                OCEANIC_BASE, this_timestamp);
+
+            if (this_map[j] <= 0)
+                continue; // Nothing more to collide.
+        } else if (prev_is_oceanic) {
+            const float sediment = SUBDUCT_RATIO * OCEANIC_BASE *
+                                   (CONTINENTAL_BASE - hmap[k]) /
+                                   CONTINENTAL_BASE;
+
+            subductions->add(i, imap[k], x_mod, y_mod, sediment);
+            ++oceanic_collisions;
+
+            const uint32_t prev_timestamp = plates[imap[k]]->
+                                            getCrustTimestamp(x_mod, y_mod);
+            plates[imap[k]]->setCrust(x_mod, y_mod, hmap[k] -
+                                      OCEANIC_BASE, prev_timestamp);
+            hmap[k] -= OCEANIC_BASE;
+
+            if (hmap[k] <= 0) {
+                imap[k] = i;
+                hmap[k] = this_map[j];
+                amap[k] = this_age[j];
+
+                continue;
             }
         }
+
+        resolveJuxtapositions(i, j, k, x_mod, y_mod,
+                              this_map, this_age, continental_collisions);
+    }
+}
+
+// Merge a continent of plate i into the other plate if the continents
+// have collided for long enough or over a large enough part of them.
+// Returns whether crust was aggregated.
+bool lithosphere::resolveCollision(uint32_t i, uint32_t other, uint32_t wx, uint32_t wy)
+{
+    uint32_t coll_count, coll_count_i, coll_count_j;
+    float coll_ratio, coll_ratio_i, coll_ratio_j;
+
+    plates[i]->getCollisionInfo(wx, wy, &coll_count_i, &coll_ratio_i);
+    plates[other]->getCollisionInfo(wx, wy, &coll_count_j, &coll_ratio_j);
+
+    // Find the minimum count of collisions between two
+    // continents on different plates.
+    // It's minimum because large plate will get collisions
+    // from all over whereas smaller plate will get just
+    // a few. It's those few that matter between these two
+    // plates, not what the big plate has with all the
+    // other plates around it.
+    coll_count = coll_count_i;
+    coll_count -= (coll_count - coll_count_j) &
+                  -(coll_count > coll_count_j);
+
+    // Find maximum amount of collided surface area between
+    // two continents on different plates.
+    // Like earlier, it's the "experience" of the smaller
+    // plate that matters here.
+    coll_ratio = coll_ratio_i;
+    coll_ratio += (coll_ratio_j - coll_ratio) *
+                  (coll_ratio_j > coll_ratio);
+
+    if ((coll_count > aggr_overlap_abs) |
+            (coll_ratio > aggr_overlap_rel))
+    {
+        float amount = plates[i]->aggregateCrust(plates[other], wx, wy);
+
+        // Calculate new direction and speed for the
+        // merged plate system, that is, for the
+        // receiving plate!
+        plates[other]->collide(*plates[i], wx, wy, amount);
+        return true;
     }
+    return false;
 }
 
 void lithosphere::updateCollisions()
 {
-    for (uint32_t i = 0; i < num_plates; ++i)
+    if (collision_resolution == COLLISIONS_PER_CONTINENT) {
+        updateContinentCollisions();
+        return;
+    }
+
+    // Until some crust is aggregated, the collision info of two continents
+    // stays the same. So of a run of collisions between the same two
+    // continents only the first one needs to look at it.
+    uint32_t aggregations = 0;
+    uint32_t last = BAD_INDEX;
+    uint32_t last_aggregations = 0;
+
+    collisions->groupByPlate(num_plates);
+    for (const uint32_t n : collisions->order)
     {
-        for (uint32_t j = 0; j < collisions[i].size(); ++j)
-        {
-            const plateCollision& coll = collisions[i][j];
-            uint32_t coll_count, coll_count_i, coll_count_j;
-            float coll_ratio, coll_ratio_i, coll_ratio_j;
-
-            ASSERT(i != coll.index, "when colliding: SRC == DEST!");
-
-            // Collision causes friction. Apply it to both plates.
-            plates[i]->applyFriction(coll.crust);
-            plates[coll.index]->applyFriction(coll.crust);
-
-            plates[i]->getCollisionInfo(coll.wx, coll.wy,
-                                        &coll_count_i, &coll_ratio_i);
-            plates[coll.index]->getCollisionInfo(coll.wx,
-                                                 coll.wy, &coll_count_j, &coll_ratio_j);
-
-            // Find the minimum count of collisions between two
-            // continents on different plates.
-            // It's minimum because large plate will get collisions
-            // from all over whereas smaller plate will get just
-            // a few. It's those few that matter between these two
-            // plates, not what the big plate has with all the
-            // other plates around it.
-            coll_count = coll_count_i;
-            coll_count -= (coll_count - coll_count_j) &
-                          -(coll_count > coll_count_j);
-
-            // Find maximum amount of collided surface area between
-            // two continents on different plates.
-            // Like earlier, it's the "experience" of the smaller
-            // plate that matters here.
-            coll_ratio = coll_ratio_i;
-            coll_ratio += (coll_ratio_j - coll_ratio) *
-                          (coll_ratio_j > coll_ratio);
-
-            if ((coll_count > aggr_overlap_abs) |
-                    (coll_ratio > aggr_overlap_rel))
-            {
-                float amount = plates[i]->aggregateCrust(
-                                   plates[coll.index],
-                                   coll.wx, coll.wy);
-
-                // Calculate new direction and speed for the
-                // merged plate system, that is, for the
-                // receiving plate!
-                plates[coll.index]->collide(*plates[i],
-                                            coll.wx, coll.wy, amount);
-            }
+        const uint32_t i = collisions->plate[n];
+        const uint32_t other = collisions->index[n];
+        const float crust = collisions->crust[n];
+
+        ASSERT(i != other, "when colliding: SRC == DEST!");
+
+        // Collision causes friction. Apply it to both plates.
+        plates[i]->applyFriction(crust);
+        plates[other]->applyFriction(crust);
+
+        if (last != BAD_INDEX && last_aggregations == aggregations &&
+                collisions->samePair(last, n)) {
+            continue;
         }
+        last = n;
+        last_aggregations = aggregations;
+
+        aggregations += resolveCollision(i, other, collisions->wx[n],
+                                         collisions->wy[n]);
+    }
+
+    collisions->clear();
+}
+
+void lithosphere::updateContinentCollisions()
+{
+    // All collisions between the same two continents cause friction at
+    // once, and the first point of them stands for the pair when checking
+    // for aggregation.
+    collisions->sumByContinents(num_plates);
+    for (uint32_t pair = 0; pair < collisions->pair_first.size(); ++pair)
+    {
+        const uint32_t first = collisions->pair_first[pair];
+        const uint32_t i = collisions->plate[first];
+        const uint32_t other = collisions->index[first];
+        const float crust = collisions->pair_crust[pair];
+
+        ASSERT(i != other, "when colliding: SRC == DEST!");
 
-        collisions[i].clear();
+        plates[i]->applyFriction(crust);
+        plates[other]->applyFriction(crust);
+
+        resolveCollision(i, other, collisions->wx[first], collisions->wy[first]);
+    }
+
+    collisions->clear();
+}
+
+// Give the map points of plate "from" to plate "to".
+void lithosphere::renameOwner(uint32_t from, uint32_t to)
+{
+    const uint32_t world_width = _worldDimension.getWidth();
+    const uint32_t world_height = _worldDimension.getHeight();
+    const uint32_t x0 = plates[to]->getLeftAsUint();
+    const uint32_t y0 = plates[to]->getTopAsUint();
+    const uint32_t w = plates[to]->getWidth();
+    const uint32_t h = plates[to]->getHeight();
+
+    const uint32_t x_mod_start = (x0 + world_width) % world_width;
+    uint32_t y_mod = (y0 + world_height) % world_height;
+
+    for (uint32_t y = 0; y < h; ++y,
+            y_mod = ++y_mod >= world_height ? y_mod - world_height : y_mod)
+    {
+        const uint32_t y_width = y_mod * world_width;
+        uint32_t x_mod = x_mod_start;
+
+        for (uint32_t x = 0; x < w; ++x,
+                x_mod = ++x_mod >= world_width ? x_mod - world_width : x_mod)
+        {
+            if (imap[x_mod + y_width] == from)
+                imap[x_mod + y_width] = to;
+        }
     }
 }
 
@@ -598,16 +853,19 @@ void lithosphere::removeEmptyPlates()
             puts("ONLY ONE PLATE LEFT!");
         else if (plate_indices_found[i] == 0)
         {
+            const uint32_t last = num_plates - 1;
+
             delete plates[i];
-            plates[i] = plates[num_plates - 1];
-            plate_indices_found[i] = plate_indices_found[num_plates - 1];
+            plates[i] = plates[last];
+            plate_indices_found[i] = plate_indices_found[last];
 
             // Life is seldom as simple as seems at first.
             // Replace the moved plate's index in the index map
             // to match its current position in the array!
-            for (uint32_t j = 0; j < _worldDimension.getArea(); ++j)
-                if (imap[j] == num_plates - 1)
-                    imap[j] = i;
+            // Every point a plate owns is within the plate's bounds, so
+            // there is no need to look at the rest of the map.
+            if (i < last)
+                renameOwner(last, i);
 
             --num_plates;
             --i;
@@ -615,6 +873,26 @@ void lithosphere::removeEmptyPlates()
     }
 }
 
+void lithosphere::movePlates(bool erode)
+{
+    // Plates don't share any state here (each one has its own random
+    // source), so they are processed in parallel with the same result.
+    _threadPool.parallelFor(num_plates, [this, erode](uint32_t i)
+    {
+        if (segmentation == SEGMENTS_LAZY_FLOOD)
+            plates[i]->resetSegments();
+
+        if (erode)
+            erosion->erode(*plates[i], CONTINENTAL_BASE);
+
+        plates[i]->move();
+
+        // Labelled last, so that the labels are of the crust as eroded.
+        if (segmentation == SEGMENTS_UNION_FIND)
+            plates[i]->labelSegments();
+    });
+}
+
 void lithosphere::update()
 {
     try {
@@ -650,92 +928,125 @@ void lithosphere::update()
         prev_imap.copy(imap);
 
         // Realize accumulated external forces to each plate.
-        for (uint32_t i = 0; i < num_plates; ++i)
         {
-            plates[i]->resetSegments();
-
-            if (erosion_period > 0 && iter_count % erosion_period == 0)
-                plates[i]->erode(CONTINENTAL_BASE);
-
-            plates[i]->move();
+            PHASE_TIMER(_phaseStats[PHASE_MOVE_AND_ERODE]);
+            movePlates(erosion_schedule == EROSION_PERIODIC &&
+                       erosion_period > 0 && iter_count % erosion_period == 0);
         }
 
         uint32_t oceanic_collisions = 0;
         uint32_t continental_collisions = 0;
 
-        updateHeightAndPlateIndexMaps(map_area, oceanic_collisions, continental_collisions);
+        {
+            PHASE_TIMER(_phaseStats[PHASE_UPDATE_MAPS]);
+            updateHeightAndPlateIndexMaps(map_area, oceanic_collisions, continental_collisions);
+        }
 
         // Update the counter of iterations since last continental collision.
         last_coll_count = (last_coll_count + 1) & -(continental_collisions == 0);
 
-        for (uint32_t i = 0; i < num_plates; ++i)
         {
-            for (uint32_t j = 0; j < subductions[i].size(); ++j)
+            PHASE_TIMER(_phaseStats[PHASE_SUBDUCTIONS]);
+            subductions->groupByPlate(num_plates);
+            for (const uint32_t n : subductions->order)
             {
-                const plateCollision& coll = subductions[i][j];
+                const uint32_t i = subductions->plate[n];
+                const uint32_t other = subductions->index[n];
 
-                ASSERT(i != coll.index, "when subducting: SRC == DEST!");
+                ASSERT(i != other, "when subducting: SRC == DEST!");
 
                 // Do not apply friction to oceanic plates.
                 // This is a very cheap way to emulate slab pull.
                 // Just perform subduction and on our way we go!
                 plates[i]->addCrustBySubduction(
-                    coll.wx, coll.wy, coll.crust, iter_count,
-                    plates[coll.index]->getVelX(),
-                    plates[coll.index]->getVelY());
+                    subductions->wx[n], subductions->wy[n], subductions->crust[n],
+                    iter_count, plates[other]->getVelX(),
+                    plates[other]->getVelY());
             }
-
-            subductions[i].clear();
+            subductions->clear();
         }
 
-        updateCollisions();
+        {
+            PHASE_TIMER(_phaseStats[PHASE_COLLISIONS]);
+            updateCollisions();
+        }
 
         fill(plate_indices_found.begin(), plate_indices_found.end(), 0);
 
-        // Fill divergent boundaries with new crustal material, molten magma.
-        for (uint32_t y = 0, i = 0; y < BOOL_REGENERATE_CRUST * _worldDimension.getHeight(); ++y) {
-            for (uint32_t x = 0; x < _worldDimension.getWidth(); ++x, ++i) {
-                if (imap[i] >= num_plates) {
-                    // The owner of this new crust is that neighbour plate
-                    // who was located at this point before plates moved.
-                    imap[i] = prev_imap[i];
-
-                    // If this is oceanic crust then add buoyancy to it.
-                    // Magma that has just crystallized into oceanic crust
-                    // is more buoyant than that which has had a lot of
-                    // time to cool down and become more dense.
-                    amap[i] = iter_count;
-                    hmap[i] = OCEANIC_BASE * BUOYANCY_BONUS_X;
-
-                    // This should probably not happen
-                    if (imap[i] < num_plates) {
-                        plates[imap[i]]->setCrust(x, y, OCEANIC_BASE,
-                                                  iter_count);
+        // Fill divergent boundaries with new crustal material, molten magma,
+        // and add some "virginity buoyancy" to all pixels for a visual
+        // boost! :) Both are done in one pass, as neither depends on the
+        // other points of the map. removeEmptyPlates() in between only
+        // renames plates in the index map, so it can safely come after.
+        {
+            PHASE_TIMER(_phaseStats[PHASE_REGENERATE_CRUST]);
+            const uint32_t world_width = _worldDimension.getWidth();
+            const uint32_t world_height = _worldDimension.getHeight();
+            const uint32_t plate_count = num_plates;
+            const uint32_t now = iter_count;
+            float* const heights = hmap.raw_data();
+            uint32_t* const owners = imap.raw_data();
+            const uint32_t* const prev_owners = prev_imap.raw_data();
+            uint32_t* const ages = amap.raw_data();
+
+            // Points are counted for their owner in runs: most neighbours
+            // belong to the same plate and this keeps the counters out of
+            // the inner loop.
+            uint32_t run_owner = 0;
+            uint32_t run_length = 0;
+
+            for (uint32_t y = 0, i = 0; y < world_height; ++y) {
+                for (uint32_t x = 0; x < world_width; ++x, ++i) {
+                    if (BOOL_REGENERATE_CRUST && owners[i] >= plate_count) {
+                        // The owner of this new crust is that neighbour plate
+                        // who was located at this point before plates moved.
+                        owners[i] = prev_owners[i];
+
+                        // If this is oceanic crust then add buoyancy to it.
+                        // Magma that has just crystallized into oceanic crust
+                        // is more buoyant than that which has had a lot of
+                        // time to cool down and become more dense.
+                        ages[i] = now;
+                        heights[i] = OCEANIC_BASE * BUOYANCY_BONUS_X;
+
+                        // This should probably not happen
+                        if (owners[i] < plate_count) {
+                            plates[owners[i]]->setCrust(x, y, OCEANIC_BASE, now);
+                        }
+
+                    } else if (BOOL_REGENERATE_CRUST) {
+                        if (owners[i] != run_owner) {
+                            plate_indices_found[run_owner] += run_length;
+                            run_owner = owners[i];
+                            run_length = 0;
+                        }
+                        ++run_length;
+
+                        if (heights[i] <= 0) {
+                            puts("Occupied point has no land mass!");
+                            exit(1);
+                        }
                     }
 
-                } else if (++plate_indices_found[imap[i]] && hmap[i] <= 0) {
-                    puts("Occupied point has no land mass!");
-                    exit(1);
+                    if (BUOYANCY_BONUS_X > 0) {
+                        // Calculate the inverted age of this piece of crust.
+                        // Force result to be minimum between inv. age and
+                        // max buoyancy bonus age.
+                        uint32_t crust_age = now - ages[i];
+                        crust_age = MAX_BUOYANCY_AGE - crust_age;
+                        crust_age &= -(crust_age <= MAX_BUOYANCY_AGE);
+
+                        heights[i] += (heights[i] < CONTINENTAL_BASE) * BUOYANCY_BONUS_X *
+                                      OCEANIC_BASE * crust_age * MULINV_MAX_BUOYANCY_AGE;
+                    }
                 }
             }
+            plate_indices_found[run_owner] += run_length;
         }
 
-        removeEmptyPlates();
-
-        //delete[] indexFound;
-
-        // Add some "virginity buoyancy" to all pixels for a visual boost! :)
-        for (uint32_t i = 0; i < (BUOYANCY_BONUS_X > 0) * map_area; ++i)
         {
-            // Calculate the inverted age of this piece of crust.
-            // Force result to be minimum between inv. age and
-            // max buoyancy bonus age.
-            uint32_t crust_age = iter_count - amap[i];
-            crust_age = MAX_BUOYANCY_AGE - crust_age;
-            crust_age &= -(crust_age <= MAX_BUOYANCY_AGE);
-
-            hmap[i] += (hmap[i] < CONTINENTAL_BASE) * BUOYANCY_BONUS_X *
-                       OCEANIC_BASE * crust_age * MULINV_MAX_BUOYANCY_AGE;
+            PHASE_TIMER(_phaseStats[PHASE_REMOVE_EMPTY_PLATES]);
+            removeEmptyPlates();
         }
 
         ++iter_count;
@@ -757,6 +1068,9 @@ void lithosphere::restart()
         if (cycle_count > max_cycles)
             return;
 
+        if (erosion_schedule == EROSION_AT_END)
+            erodePlates();
+
         // Update height map to include all recent changes.
         hmap.set_all(0);
         for (uint32_t i = 0; i < num_plates; ++i)
@@ -863,3 +1177,15 @@ const plate* lithosphere::getPlate(uint32_t index) const
     ASSERT(index < num_plates, "invalid plate index");
     return plates[index];
 }
+
+const PhaseStats& lithosphere::getPhaseStats(uint32_t phase) const
+{
+    ASSERT(phase < PHASE_COUNT, "invalid update phase");
+    return _phaseStats[phase];
+}
+
+void lithosphere::resetPhaseStats()
+{
+    for (uint32_t i = 0; i < PHASE_COUNT; ++i)
+        _phaseStats[i].reset();
+}
@@ -21,6 +21,7 @@
 #define LITHOSPHERE_HPP
 
 #include <cstring> // For size_t.
+#include <memory>
 #include <stdexcept>
 #include <vector>
 #ifdef __MINGW32__ // this is to avoid a problem with the hypot function which is messed up by Python...
@@ -28,15 +29,32 @@
 #endif
 #include <cmath>
 #include "heightmap.hpp"
+#include "phase_stats.hpp"
+#include "erosion.hpp"
 #include "rectangle.hpp"
+#include "segment_creator.hpp"
 #include "simplerandom.hpp"
+#include "thread_pool.hpp"
 
 using namespace std;
 
 #define CONTINENTAL_BASE 1.0f
 #define OCEANIC_BASE     0.1f
 
+/// How lithosphere::update() handles the continental collisions of a step.
+enum CollisionResolution
+{
+    /// Friction and the check for aggregation for every collided point.
+    /// The original method.
+    COLLISIONS_PER_POINT = 0,
+    /// The collided points of each two continents are summed up first, so
+    /// friction and the check for aggregation happen once per pair.
+    COLLISIONS_PER_CONTINENT,
+    COLLISION_RESOLUTION_COUNT
+};
+
 class plate;
+class plateCollisions;
 
 /**
 * Wrapper for growing plate from a seed. Contains plate's dimensions.
@@ -79,6 +97,8 @@ public:
      * @param aggr_ratio_abs # of overlapping points causing aggregation.
      * @param aggr_ratio_rel % of overlapping area causing aggregation.
      * @param num_cycles Number of times system will be restarted.
+     * @param num_threads Threads used to update plates, 0 = one per core.
+     *                    Results do not depend on the number of threads.
      * @exception	invalid_argument Exception is thrown if map side length
      *           	is not a power of two and greater than three.
      */
@@ -87,7 +107,8 @@ public:
                 float sea_level,
                 uint32_t _erosion_period, float _folding_ratio,
                 uint32_t aggr_ratio_abs, float aggr_ratio_rel,
-                uint32_t num_cycles, uint32_t _max_plates) noexcept(false);
+                uint32_t num_cycles, uint32_t _max_plates,
+                uint32_t num_threads = 1) noexcept(false);
 
     ~lithosphere() noexcept; ///< Standard destructor.
 
@@ -119,6 +140,59 @@ public:
     bool isFinished() const;
     const plate* getPlate(uint32_t index) const;
 
+    /// Reset the segments of, erode if asked to and move every plate, the
+    /// first phase of update(). With SEGMENTS_UNION_FIND the continents
+    /// are labelled after the plates have moved.
+    // Visible for testing
+    void movePlates(bool erode);
+
+    /// Time spent in the given phase of update() since creation or the
+    /// last resetPhaseStats(). Always zero unless the library was built
+    /// with PLATEC_PHASE_STATS.
+    const PhaseStats& getPhaseStats(uint32_t phase) const;
+    void resetPhaseStats(); ///< Zero the counters of every update phase.
+
+    /// Erode plates with RiverErosion finding the paths of rivers the
+    /// given way, RIVERS_FRONTIER by default. Takes effect at the next
+    /// erosion.
+    void setRiverRouting(RiverRouting routing);
+    /// Routing of the RiverErosion plates are eroded with, RIVERS_FRONTIER
+    /// if they are eroded another way.
+    RiverRouting getRiverRouting() const noexcept;
+
+    /// Erode plates with the given strategy from the next erosion on.
+    /// Takes ownership of erosion, which must not be null.
+    void setErosion(IErosion* erosion);
+    const IErosion& getErosion() const noexcept {
+        return *erosion;
+    }
+
+    /// Choose when plates are eroded, EROSION_PERIODIC by default.
+    void setErosionSchedule(ErosionSchedule schedule) noexcept {
+        erosion_schedule = schedule;
+    }
+    ErosionSchedule getErosionSchedule() const noexcept {
+        return erosion_schedule;
+    }
+
+    /// Choose how plates find their continents, SEGMENTS_LAZY_FLOOD by
+    /// default. Takes effect at the next update.
+    void setSegmentation(Segmentation _segmentation) noexcept {
+        segmentation = _segmentation;
+    }
+    Segmentation getSegmentation() const noexcept {
+        return segmentation;
+    }
+
+    /// Choose how continental collisions are handled, COLLISIONS_PER_POINT
+    /// by default. Takes effect at the next update.
+    void setCollisionResolution(CollisionResolution resolution) noexcept {
+        collision_resolution = resolution;
+    }
+    CollisionResolution getCollisionResolution() const noexcept {
+        return collision_resolution;
+    }
+
 protected:
 private:
 
@@ -128,41 +202,37 @@ private:
                                        uint32_t& oceanic_collisions,
                                        uint32_t& continental_collisions);
     void updateCollisions();
+    void updateContinentCollisions(); ///< updateCollisions() per continent pair.
+    bool resolveCollision(uint32_t i, uint32_t other, uint32_t wx, uint32_t wy);
     void clearPlates();
     void growPlates();
     void removeEmptyPlates();
+
+    /// Give the points of the index map owned by plate "from" to plate "to".
+    /// Only the bounds of plates[to], the plate being renamed, are visited.
+    void renameOwner(uint32_t from, uint32_t to);
     void resolveJuxtapositions(const uint32_t& i, const uint32_t& j, const uint32_t& k,
                                const uint32_t& x_mod, const uint32_t& y_mod,
                                const float*& this_map, const uint32_t*& this_age, uint32_t& continental_collisions);
 
     /**
-     * Container for collision details between two plates.
+     * Location where a plate has crust on top of an earlier plate.
      *
-     * In simulation there's usually 2-5 % collisions of the entire map
-     * area. In a 512*512 map that means 5000-13000 collisions.
-     *
-     * When plate collisions are recorded and processed pair-by-pair, some
-     * of the information is lost if more than two plates collide at the
-     * same point (there will be no record of the two lower plates
-     * colliding together, just that they both collided with the tallest
-     * plate) ONLY IF ALL the collisions between ANY TWO plates of that
-     * group always include a third, taller/higher  plate. This happens
-     * most often when plates have long, sharp spikes i.e. in the
-     * beginning.
+     * Recorded while compositing plates onto the world map and resolved
+     * afterwards in plate order, see updateHeightAndPlateIndexMaps().
      */
-    class plateCollision
+    class plateOverlap
     {
     public:
-        plateCollision(uint32_t _index, uint32_t x, uint32_t y, float z)
-        noexcept : index(_index), wx(x), wy(y), crust(z) {
-            ASSERT(crust >= 0, "Crust must be a positive value");
-        }
-        uint32_t index; ///< Index of the other plate involved in the event.
-        uint32_t wx, wy; ///< Coordinates of collision in world space.
-        float crust; ///< Amount of crust that will deform/subduct.
+        plateOverlap(uint32_t _plate, uint32_t _index, uint32_t _world_index)
+        noexcept : plate(_plate), index(_index), world_index(_world_index) {}
+        uint32_t plate; ///< Index of the plate arriving on the location.
+        uint32_t index; ///< Location in the arriving plate's local map.
+        uint32_t world_index; ///< Location on the world map.
     };
 
     void restart(); //< Replace plates with a new population.
+    void erodePlates(); ///< Apply the erosion to every plate.
     WorldPoint randomPosition();
 
     HeightMap hmap; ///< Height map representing the topography of system.
@@ -182,9 +252,16 @@ private:
     uint32_t max_cycles; ///< Max n:o of times the system'll be restarted.
     uint32_t max_plates; ///< Number of plates in the initial setting.
     uint32_t num_plates; ///< Number of plates in the current setting.
+    unique_ptr<IErosion> erosion; ///< Erosion applied to plates.
+    ErosionSchedule erosion_schedule; ///< When plates are eroded.
+    Segmentation segmentation; ///< How plates find their continents.
+    CollisionResolution collision_resolution; ///< How collisions are handled.
 
-    vector<vector<plateCollision> > collisions;
-    vector<vector<plateCollision> > subductions;
+    unique_ptr<plateCollisions> collisions;
+    unique_ptr<plateCollisions> subductions;
+    vector<vector<plateOverlap> > overlap_bands; ///< Overlaps per band of rows.
+    /// Per plate, the plates before it whose bounds overlap its own.
+    vector<vector<uint32_t> > earlier_overlaps;
 
     float peak_Ek{}; ///< Max total kinetic energy in the system so far.
     uint32_t last_coll_count{}; ///< Iterations since last cont. collision.
@@ -192,6 +269,9 @@ private:
     const WorldDimension _worldDimension;
     SimpleRandom _randsource;
     int _steps;
+
+    PhaseStats _phaseStats[PHASE_COUNT]; ///< Per-phase profile of update().
+    ThreadPool _threadPool; ///< Workers for the per-plate parts of update().
 };
 
 
@@ -17,7 +17,9 @@
  *  License along with this library; if not, see http://www.gnu.org/licenses/
  *****************************************************************************/
 
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <math.h>
 #include "noise.hpp"
 #include "sqrdmd.hpp"
@@ -44,7 +46,8 @@ static uint32_t nearest_pow(uint32_t num)
     return n;
 }
 
-void createSlowNoise(float* map, const WorldDimension& tmpDim, SimpleRandom randsource)
+void createSlowNoise(float* map, const WorldDimension& tmpDim, SimpleRandom randsource,
+                     ThreadPool* pool)
 {
     int64_t seed = randsource.next();
     uint32_t width = tmpDim.getWidth();
@@ -55,35 +58,68 @@ void createSlowNoise(float* map, const WorldDimension& tmpDim, SimpleRandom rand
     float kb = static_cast<float>(seed*567%256);
     float kc = static_cast<float>((seed*seed) % 256);
     float kd = static_cast<float>((567-seed) % 256);
+
+    // The first two coordinates only depend on the column and the last two
+    // on the row: a point at (x, y) is at (xs[x], ys[x], zs[y], ws[y]).
+    vector<float> xs(width), ys(width), zs(height), ws(height);
+    for (uint32_t x = 0; x < width; x++) {
+        float fNX = x/(float)width; // we let the x-offset define the circle
+        float fRdx = fNX*2.0f*PI; // a full circle is two pi radians
+        float fRdsSin = 1.0f;
+        float a = static_cast<float>(fRdsSin*sinf(fRdx));
+        float b = static_cast<float>(fRdsSin*cosf(fRdx));
+        xs[x] = ka+a*noiseScale;
+        ys[x] = kb+b*noiseScale;
+    }
     for (uint32_t y = 0; y < height; y++) {
-        for (uint32_t x = 0; x < width; x++) {
-            float fNX = x/(float)width; // we let the x-offset define the circle
-            float fNY = y/(float)height; // we let the x-offset define the circle
-            float fRdx = fNX*2.0f*PI; // a full circle is two pi radians
-            float fRdy = fNY*4.0f*PI; // a full circle is two pi radians
-            float fRdsSin = 1.0f;
-            float a = static_cast<float>(fRdsSin*sinf(fRdx));
-            float b = static_cast<float>(fRdsSin*cosf(fRdx));
-            float c = static_cast<float>(fRdsSin*sinf(fRdy));
-            float d = static_cast<float>(fRdsSin*cosf(fRdy));
-            float v = scaled_octave_noise_4d(4.0f,
-                                             persistence,
-                                             0.25f,
-                                             0.0f,
-                                             1.0f,
-                                             ka+a*noiseScale,
-                                             kb+b*noiseScale,
-                                             kc+c*noiseScale,
-                                             kd+d*noiseScale);
-            map[y * width + x] = v;
+        float fNY = y/(float)height; // we let the x-offset define the circle
+        float fRdy = fNY*4.0f*PI; // a full circle is two pi radians
+        float fRdsSin = 1.0f;
+        float c = static_cast<float>(fRdsSin*sinf(fRdy));
+        float d = static_cast<float>(fRdsSin*cosf(fRdy));
+        zs[y] = kc+c*noiseScale;
+        ws[y] = kd+d*noiseScale;
+    }
+
+    // Rows are independent, bands of them are computed in parallel.
+    const uint32_t num_bands = pool ? min(pool->size(), height) : 1;
+    const auto fillBand = [&](uint32_t band) {
+        const uint32_t band_top = band * height / num_bands;
+        const uint32_t band_btm = (band + 1) * height / num_bands;
+        vector<float> row_zs(width), row_ws(width);
+        for (uint32_t y = band_top; y < band_btm; y++) {
+            fill(row_zs.begin(), row_zs.end(), zs[y]);
+            fill(row_ws.begin(), row_ws.end(), ws[y]);
+            scaled_octave_noise_4d(4.0f,
+                                   persistence,
+                                   0.25f,
+                                   0.0f,
+                                   1.0f,
+                                   xs.data(),
+                                   ys.data(),
+                                   row_zs.data(),
+                                   row_ws.data(),
+                                   map + y * width,
+                                   width);
         }
+    };
+    if (pool) {
+        pool->parallelFor(num_bands, fillBand);
+    } else {
+        fillBand(0);
     }
 }
 
 void createNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom randsource, bool useSimplex)
+{
+    createNoise(tmp, tmpDim, randsource, useSimplex ? NOISE_SIMPLEX : NOISE_SQRDMD);
+}
+
+void createNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom randsource,
+                 NoiseGenerator generator, ThreadPool* pool)
 {
     try {
-        if (useSimplex) {
+        if (generator == NOISE_SIMPLEX) {
             simplexnoise(randsource.next(), tmp,
                          tmpDim.getWidth(),
                          tmpDim.getHeight(),
@@ -114,7 +150,11 @@ void createNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom randsour
                 }
             }
 
-            sqrdmd(randsource.next(), squareTmp, side, SQRDMD_ROUGHNESS);
+            if (generator == NOISE_SQRDMD_HASHED) {
+                sqrdmd_hashed(randsource.next(), squareTmp, side, SQRDMD_ROUGHNESS, pool);
+            } else {
+                sqrdmd(randsource.next(), squareTmp, side, SQRDMD_ROUGHNESS);
+            }
 
             // Calcuate deltas (noise introduced)
             float* deltas = new float[tmpDim.getWidth()*tmpDim.getHeight()];
@@ -25,8 +25,30 @@
 #endif
 #include "rectangle.hpp"
 #include "simplerandom.hpp"
+#include "thread_pool.hpp"
+
+/// Height map generators of createNoise().
+enum NoiseGenerator
+{
+    /// Square-diamond drawing its offsets from one random sequence, on one
+    /// thread. The original generator.
+    NOISE_SQRDMD = 0,
+    /// Square-diamond with offsets hashed from the seed and the point, so
+    /// each level is computed in parallel. See sqrdmd_hashed().
+    NOISE_SQRDMD_HASHED,
+    /// Tileable simplex noise.
+    NOISE_SIMPLEX,
+    NOISE_GENERATOR_COUNT
+};
 
 void createNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom _randsource, bool useSimplex = false);
-void createSlowNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom _randsource);
+/// Add noise of the given generator to tmp. The pool is only used by
+/// NOISE_SQRDMD_HASHED, whose result doesn't depend on its size.
+void createNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom _randsource,
+                 NoiseGenerator generator, ThreadPool* pool = nullptr);
+/// Tileable 4D simplex noise. The same for any number of threads in pool;
+/// without a pool the noise is computed on the calling thread only.
+void createSlowNoise(float* tmp, const WorldDimension& tmpDim, SimpleRandom _randsource,
+                     ThreadPool* pool = nullptr);
 
 #endif
@@ -0,0 +1,100 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#ifndef PHASE_STATS_HPP
+#define PHASE_STATS_HPP
+
+#include "utils.hpp"
+
+#ifdef PLATEC_PHASE_STATS
+#include <chrono>
+#endif
+
+/// Phases of lithosphere::update() that are timed when the library is
+/// built with PLATEC_PHASE_STATS (CMake option WITH_PHASE_STATS).
+enum UpdatePhase
+{
+    PHASE_MOVE_AND_ERODE = 0,  ///< movePlates().
+    PHASE_UPDATE_MAPS,         ///< updateHeightAndPlateIndexMaps().
+    PHASE_SUBDUCTIONS,         ///< Application of the recorded subductions.
+    PHASE_COLLISIONS,          ///< updateCollisions().
+    PHASE_REGENERATE_CRUST,    ///< New crust at divergent boundaries and buoyancy bonus.
+    PHASE_REMOVE_EMPTY_PLATES, ///< removeEmptyPlates().
+    PHASE_COUNT
+};
+
+/// Accumulated wall time and number of executions of one update phase.
+class PhaseStats
+{
+public:
+    PhaseStats() : calls(0), seconds(0.0) {}
+
+    void reset()
+    {
+        calls = 0;
+        seconds = 0.0;
+    }
+
+    uint64_t calls;  ///< Number of times the phase was executed.
+    double seconds;  ///< Total wall time spent in the phase.
+};
+
+/// Human readable name of the given phase, nullptr if the phase is unknown.
+const char* phaseName(uint32_t phase);
+
+#ifdef PLATEC_PHASE_STATS
+
+/// Measure the wall time of the enclosing scope and add it to the stats.
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(PhaseStats& stats)
+        : _stats(stats), _start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~PhaseTimer()
+    {
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - _start;
+        _stats.seconds += elapsed.count();
+        ++_stats.calls;
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    PhaseStats& _stats;
+    const std::chrono::steady_clock::time_point _start;
+};
+
+#define PHASE_TIMER_CONCAT_(a, b) a##b
+#define PHASE_TIMER_CONCAT(a, b) PHASE_TIMER_CONCAT_(a, b)
+#define PHASE_TIMER(stats) \
+	PhaseTimer PHASE_TIMER_CONCAT(phase_timer_, __LINE__)(stats)
+
+#else
+
+// Instrumentation is compiled out: no clock reads, no counters.
+#define PHASE_TIMER(stats) do { } while (false)
+
+#endif
+
+#endif
@@ -46,11 +46,18 @@ plate::plate(long seed, float* m, uint32_t w, uint32_t h, uint32_t _x, uint32_t
     _mass(MassBuilder(m, Dimension(w, h)).build()),
     _movement(_randsource, worldDimension),
     _segments(nullptr),
-    _mySegmentCreator(nullptr)
+    _ownBounds(nullptr),
+    _ownSegments(nullptr),
+    _mySegmentCreator(nullptr),
+    _crustVersion(1),
+    _segmentsVersion(0),
+    _segmentsCreations(0),
+    _segmentation(SEGMENTS_LAZY_FLOOD)
 {
     const uint32_t plate_area = w * h;
 
-    _bounds = new Bounds(worldDimension, FloatPoint(static_cast<float>(_x), static_cast<float>(_y)), Dimension(w, h));
+    _ownBounds = new Bounds(worldDimension, FloatPoint(static_cast<float>(_x), static_cast<float>(_y)), Dimension(w, h));
+    _bounds = _ownBounds;
 
     uint32_t k;
     for (uint32_t y = k = 0; y < _bounds->height(); ++y) {
@@ -63,11 +70,11 @@ plate::plate(long seed, float* m, uint32_t w, uint32_t h, uint32_t _x, uint32_t
             age_map.set(x, y, plate_age & -(m[k] > 0));
         }
     }
-    Segments* segments = new Segments(plate_area);
-    _segments = segments;
-    _mySegmentCreator = new MySegmentCreator(*_bounds, _segments, map, _worldDimension);
-    segments->setSegmentCreator(_mySegmentCreator);
-    segments->setBounds(_bounds);
+    _ownSegments = new Segments(plate_area);
+    _segments = _ownSegments;
+    _mySegmentCreator = new MySegmentCreator(*_ownBounds, _ownSegments, map, _worldDimension);
+    _ownSegments->setSegmentCreator(_mySegmentCreator);
+    _ownSegments->setBounds(_ownBounds);
 }
 
 plate::~plate()
@@ -77,10 +84,14 @@ plate::~plate()
     delete _bounds;
 }
 
-uint32_t plate::addCollision(uint32_t wx, uint32_t wy)
+uint32_t plate::addCollision(uint32_t wx, uint32_t wy, ContinentId* continent)
 {
-    ISegmentData& seg = getContinentAt(wx, wy);
+    const ContinentId id = _segments->getContinentAt(wx, wy);
+    ISegmentData& seg = (*_segments)[id];
     seg.incCollCount();
+    if (continent) {
+        *continent = id;
+    }
     return seg.area();
 }
 
@@ -88,9 +99,10 @@ void plate::addCrustByCollision(uint32_t x, uint32_t y, float z, uint32_t time,
 {
     // Add crust. Extend plate if necessary.
     setCrust(x, y, getCrust(x, y) + z, time);
+    ++_crustVersion; // The segment grows even if the point was continental.
 
-    uint32_t index = _bounds->getValidMapIndex(&x, &y);
-    _segments->setId(index, activeContinent);
+    uint32_t index = validMapIndex(&x, &y);
+    setSegmentId(index, activeContinent);
 
     ISegmentData& data = (*_segments)[activeContinent];
     data.incArea();
@@ -146,6 +158,7 @@ void plate::addCrustBySubduction(uint32_t x, uint32_t y, float z, uint32_t t,
             t = (map[index] * age_map[index] + z * t) / (map[index] + z);
             age_map[index] = static_cast<uint32_t>(static_cast<float>(t) * static_cast<float>(z > 0));
 
+            _crustVersion += (map[index] >= CONT_BASE) != (map[index] + z >= CONT_BASE);
             map[index] += z;
             _mass.incMass(z);
         }
@@ -155,9 +168,9 @@ void plate::addCrustBySubduction(uint32_t x, uint32_t y, float z, uint32_t t,
 float plate::aggregateCrust(plate* p, uint32_t wx, uint32_t wy)
 {
     uint32_t lx = wx, ly = wy;
-    const uint32_t index = _bounds->getValidMapIndex(&lx, &ly);
+    const uint32_t index = validMapIndex(&lx, &ly);
 
-    const ContinentId seg_id = _segments->id(index);
+    const ContinentId seg_id = segmentId(index);
 
     // This check forces the caller to do things in proper order!
     //
@@ -191,14 +204,19 @@ float plate::aggregateCrust(plate* p, uint32_t wx, uint32_t wy)
     //      _dimension.getWidth(), _dimension.getHeight(), lx, ly);
 
     float old_mass = _mass.getMass();
+    ++_crustVersion;
 
     // Add all of the collided continent's crust to destination plate.
-    for (uint32_t y = (*_segments)[seg_id].getTop(); y <= (*_segments)[seg_id].getBottom(); ++y)
+    const ISegmentData& segment = (*_segments)[seg_id];
+    const uint32_t seg_top = segment.getTop(), seg_btm = segment.getBottom();
+    const uint32_t seg_lft = segment.getLeft(), seg_rgt = segment.getRight();
+    const uint32_t width = _bounds->width();
+    for (uint32_t y = seg_top; y <= seg_btm; ++y)
     {
-        for (uint32_t x = (*_segments)[seg_id].getLeft(); x <= (*_segments)[seg_id].getRight(); ++x)
+        for (uint32_t x = seg_lft; x <= seg_rgt; ++x)
         {
-            const uint32_t i = y * _bounds->width() + x;
-            if ((_segments->id(i) == seg_id) && (map[i] > 0))
+            const uint32_t i = y * width + x;
+            if ((segmentId(i) == seg_id) && (map[i] > 0))
             {
                 p->addCrustByCollision(wx + x - lx, wy + y - ly,
                                        map[i], age_map[i], activeContinent);
@@ -239,25 +257,53 @@ void plate::calculateCrust(uint32_t x, uint32_t y, uint32_t index,
                      _worldDimension, map, _bounds->width(), _bounds->height());
 }
 
+/// Heights of the 4-way neighbours of row[x] that are lower than it, zero
+/// for the others. Same results as calculateCrust(), but read from rows
+/// of the padded map, whose halo replaces the edge checks.
+static inline void lowerNeighbours(const float* above, const float* row,
+                                   const float* below, uint32_t x,
+                                   float& w_crust, float& e_crust,
+                                   float& n_crust, float& s_crust)
+{
+    const float* here = row + x;
+    const float crust = *here;
+    w_crust = here[-1] * (here[-1] < crust);
+    e_crust = here[1] * (here[1] < crust);
+    n_crust = above[x] * (above[x] < crust);
+    s_crust = below[x] * (below[x] < crust);
+}
+
+void plate::updatePaddedMap()
+{
+    // Plates as wide (tall) as the world wrap around horizontally
+    // (vertically). Elsewhere the halo is never lower than any point.
+    _paddedMap.assign(map,
+                      _bounds->width() == _worldDimension.getWidth(),
+                      _bounds->height() == _worldDimension.getHeight(),
+                      FLT_MAX);
+}
+
 void plate::findRiverSources(float lower_bound, vector<uint32_t>* sources)
 {
     const uint32_t bounds_height = _bounds->height();
     const uint32_t bounds_width = _bounds->width();
 
+    updatePaddedMap();
+
     // Find all tops.
     for (uint32_t y = 0; y < bounds_height; ++y) {
         const uint32_t y_width = y * bounds_width;
+        const float* above = _paddedMap.row(static_cast<int>(y) - 1);
+        const float* row = _paddedMap.row(y);
+        const float* below = _paddedMap.row(y + 1);
         for (uint32_t x = 0; x < bounds_width; ++x) {
-            const uint32_t index = y_width + x;
-
-            if (map[index] < lower_bound) {
+            if (row[x] < lower_bound) {
                 continue;
             }
 
             float w_crust, e_crust, n_crust, s_crust;
-            uint32_t w, e, n, s;
-            calculateCrust(x, y, index, w_crust, e_crust, n_crust, s_crust,
-                           w, e, n, s);
+            lowerNeighbours(above, row, below, x,
+                            w_crust, e_crust, n_crust, s_crust);
 
             // This location is either at the edge of the plate or it is not the
             // tallest of its neightbours. Don't start a river from here.
@@ -265,7 +311,7 @@ void plate::findRiverSources(float lower_bound, vector<uint32_t>* sources)
                 continue;
             }
 
-            sources->push_back(index);
+            sources->push_back(y_width + x);
         }
     }
 }
@@ -276,11 +322,10 @@ void plate::flowRivers(float lower_bound, vector<uint32_t>* sources, HeightMap&
     vector<uint32_t> sinks_data;
     vector<uint32_t>* sinks = &sinks_data;
 
-    static vector<bool> s_flowDone;
-    if (s_flowDone.size() < bounds_area) {
-        s_flowDone.resize(bounds_area);
+    if (_flowDone.size() < bounds_area) {
+        _flowDone.resize(bounds_area);
     }
-    fill(s_flowDone.begin(), s_flowDone.begin() + bounds_area, false);
+    fill(_flowDone.begin(), _flowDone.begin() + bounds_area, false);
 
     // From each top, start flowing water along the steepest slope.
     while (!sources->empty()) {
@@ -295,10 +340,11 @@ void plate::flowRivers(float lower_bound, vector<uint32_t>* sources, HeightMap&
                 continue;
             }
 
+            // The padded map is up to date, findRiverSources() filled it.
             float w_crust, e_crust, n_crust, s_crust;
-            uint32_t w, e, n, s;
-            calculateCrust(x, y, index, w_crust, e_crust, n_crust, s_crust,
-                           w, e, n, s);
+            lowerNeighbours(_paddedMap.row(static_cast<int>(y) - 1),
+                            _paddedMap.row(y), _paddedMap.row(y + 1), x,
+                            w_crust, e_crust, n_crust, s_crust);
 
             // If this is the lowest part of its neighbourhood, stop.
             if (w_crust + e_crust + n_crust + s_crust == 0) {
@@ -330,9 +376,9 @@ void plate::flowRivers(float lower_bound, vector<uint32_t>* sources, HeightMap&
             }
 
             // if it's not handled yet, add it as new sink.
-            if (dest < _bounds->area() && !s_flowDone[dest]) {
+            if (dest < _bounds->area() && !_flowDone[dest]) {
                 sinks->push_back(dest);
-                s_flowDone[dest] = true;
+                _flowDone[dest] = true;
             }
 
             // Erode this location with the water flow.
@@ -347,14 +393,33 @@ void plate::flowRivers(float lower_bound, vector<uint32_t>* sources, HeightMap&
     }
 }
 
-void plate::erode(float lower_bound)
+void plate::floodRivers(float lower_bound, const vector<uint32_t>& sources, HeightMap& tmp)
+{
+    ::floodRivers(map, lower_bound,
+                  _bounds->width() == _worldDimension.getWidth(),
+                  _bounds->height() == _worldDimension.getHeight(),
+                  sources, _floodUpstream, _floodScratch);
+
+    // Erode every location with water from some source flowing through it.
+    for (uint32_t i = 0; i < _bounds->area(); ++i) {
+        if (_floodUpstream[i] > 0 && map[i] >= lower_bound) {
+            tmp[i] -= (tmp[i] - lower_bound) * 0.2f;
+        }
+    }
+}
+
+void plate::erode(float lower_bound, RiverRouting routing)
 {
     vector<uint32_t> sources_data;
     vector<uint32_t>* sources = &sources_data;
 
     HeightMap tmpHm(map);
     findRiverSources(lower_bound, sources);
-    flowRivers(lower_bound, sources, tmpHm);
+    if (routing == RIVERS_PRIORITY_FLOOD) {
+        floodRivers(lower_bound, *sources, tmpHm);
+    } else {
+        flowRivers(lower_bound, sources, tmpHm);
+    }
 
     // Add random noise (10 %) to heightmap.
     for (uint32_t i = 0; i < _bounds->area(); ++i) {
@@ -367,110 +432,29 @@ void plate::erode(float lower_bound)
         }
     }
 
-    map = tmpHm;
-    tmpHm.set_all(0.0f);
+    // The old heights are not needed any more, so they receive the
+    // result of the redistribution below.
+    swap(map, tmpHm);
+    updatePaddedMap();
     MassBuilder massBuilder;
 
-    for (uint32_t y = 0; y < _bounds->height(); ++y)
+    const uint32_t width = _bounds->width();
+    const uint32_t height = _bounds->height();
+
+    for (uint32_t y = 0; y < height; ++y)
     {
-        for (uint32_t x = 0; x < _bounds->width(); ++x)
+        for (uint32_t x = 0; x < width; ++x)
         {
-            const uint32_t index = y * _bounds->width() + x;
-            massBuilder.addPoint(x, y, map[index]);
-            tmpHm[index] += map[index]; // Careful not to overwrite earlier amounts.
-
-            if (map[index] < lower_bound)
-                continue;
-
-            float w_crust, e_crust, n_crust, s_crust;
-            uint32_t w, e, n, s;
-            calculateCrust(x, y, index, w_crust, e_crust, n_crust, s_crust,
-                           w, e, n, s);
-
-            // This location has no neighbours (ARTIFACT!) or it is the lowest
-            // part of its area. In either case the work here is done.
-            if (w_crust + e_crust + n_crust + s_crust == 0)
-                continue;
-
-            // The steeper the slope, the more water flows along it.
-            // The more downhill (sources), the more water flows to here.
-            // 1+1+10 = 12, avg = 4, stdev = sqrt((3*3+3*3+6*6)/3) = 4.2, var = 18,
-            //  1*1+1*1+10*10 = 102, 102/4.2=24
-            // 1+4+7 = 12, avg = 4, stdev = sqrt((3*3+0*0+3*3)/3) = 2.4, var = 6,
-            //  1*1+4*4+7*7 = 66, 66/2.4 = 27
-            // 4+4+4 = 12, avg = 4, stdev = sqrt((0*0+0*0+0*0)/3) = 0, var = 0,
-            //  4*4+4*4+4*4 = 48, 48/0 = inf -> 48
-            // If there's a source slope of height X then it will always cause
-            // water erosion of amount Y. Then again from one spot only so much
-            // water can flow.
-            // Thus, the calculated non-linear flow value for this location is
-            // multiplied by the "water erosion" constant.
-            // The result is max(result, 1.0). New height of this location could
-            // be e.g. h_lowest + (1 - 1 / result) * (h_0 - h_lowest).
-
-            // Calculate the difference in height between this point and its
-            // nbours that are lower than this point.
-            float w_diff = map[index] - w_crust;
-            float e_diff = map[index] - e_crust;
-            float n_diff = map[index] - n_crust;
-            float s_diff = map[index] - s_crust;
-
-            float min_diff = w_diff;
-            min_diff -= (min_diff - e_diff) * (e_diff < min_diff);
-            min_diff -= (min_diff - n_diff) * (n_diff < min_diff);
-            min_diff -= (min_diff - s_diff) * (s_diff < min_diff);
-
-            // Calculate the sum of difference between lower neighbours and
-            // the TALLEST lower neighbour.
-            float diff_sum = (w_diff - min_diff) * (w_crust > 0) +
-                             (e_diff - min_diff) * (e_crust > 0) +
-                             (n_diff - min_diff) * (n_crust > 0) +
-                             (s_diff - min_diff) * (s_crust > 0);
-
-            // Erosion difference sum is negative!
-            ASSERT(diff_sum >= 0, "Difference sum must be positive");
-
-            if (diff_sum < min_diff)
-            {
-                // There's NOT enough room in neighbours to contain all the
-                // crust from this peak so that it would be as tall as its
-                // tallest lower neighbour. Thus first step is make ALL
-                // lower neighbours and this point equally tall.
-                tmpHm[w] += (w_diff - min_diff) * (w_crust > 0);
-                tmpHm[e] += (e_diff - min_diff) * (e_crust > 0);
-                tmpHm[n] += (n_diff - min_diff) * (n_crust > 0);
-                tmpHm[s] += (s_diff - min_diff) * (s_crust > 0);
-                tmpHm[index] -= min_diff;
-
-                min_diff -= diff_sum;
-
-                // Spread the remaining crust equally among all lower nbours.
-                min_diff /= 1 + (w_crust > 0) + (e_crust > 0) +
-                            (n_crust > 0) + (s_crust > 0);
-
-                tmpHm[w] += min_diff * (w_crust > 0);
-                tmpHm[e] += min_diff * (e_crust > 0);
-                tmpHm[n] += min_diff * (n_crust > 0);
-                tmpHm[s] += min_diff * (s_crust > 0);
-                tmpHm[index] += min_diff;
-            }
-            else
-            {
-                float unit = min_diff / diff_sum;
-
-                // Remove all crust from this location making it as tall as
-                // its tallest lower neighbour.
-                tmpHm[index] -= min_diff;
-
-                // Spread all removed crust among all other lower neighbours.
-                tmpHm[w] += unit * (w_diff - min_diff) * (w_crust > 0);
-                tmpHm[e] += unit * (e_diff - min_diff) * (e_crust > 0);
-                tmpHm[n] += unit * (n_diff - min_diff) * (n_crust > 0);
-                tmpHm[s] += unit * (s_diff - min_diff) * (s_crust > 0);
-            }
+            massBuilder.addPoint(x, y, map[y * width + x]);
         }
     }
 
+    // Spread crust from every point to its lower neighbours.
+    redistributeCrust(_paddedMap, lower_bound,
+                      width == _worldDimension.getWidth(),
+                      height == _worldDimension.getHeight(),
+                      tmpHm.raw_data());
+
     // Clamp all heightmap values to prevent negative mass from floating point errors
     // This is a safety measure for Issue #30
     for (uint32_t i = 0; i < _bounds->area(); ++i) {
@@ -479,8 +463,34 @@ void plate::erode(float lower_bound)
         }
     }
 
-    map = tmpHm;
+    map = std::move(tmpHm);
     _mass = massBuilder.build();
+    ++_crustVersion;
+}
+
+void plate::smooth(float lower_bound, float talus, float rate)
+{
+    const uint32_t width = _bounds->width();
+    const uint32_t height = _bounds->height();
+
+    updatePaddedMap();
+    smoothCrust(_paddedMap, lower_bound, talus, rate, map.raw_data());
+
+    MassBuilder massBuilder;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t index = y * width + x;
+            // Rounding must not leave negative mass (Issue #30).
+            if (map[index] < 0.0f) {
+                map[index] = 0.0f;
+            }
+            massBuilder.addPoint(x, y, map[index]);
+        }
+    }
+    _mass = massBuilder.build();
+    ++_crustVersion;
 }
 
 void plate::getCollisionInfo(uint32_t wx, uint32_t wy, uint32_t* count, float* ratio) const
@@ -494,20 +504,20 @@ void plate::getCollisionInfo(uint32_t wx, uint32_t wy, uint32_t* count, float* r
 
 uint32_t plate::getContinentArea(uint32_t wx, uint32_t wy) const
 {
-    const uint32_t index = _bounds->getValidMapIndex(&wx, &wy);
-    ASSERT(_segments->id(index) < _segments->size(), "Segment index invalid");
-    return (*_segments)[_segments->id(index)].area();
+    const uint32_t index = validMapIndex(&wx, &wy);
+    ASSERT(segmentId(index) < _segments->size(), "Segment index invalid");
+    return (*_segments)[segmentId(index)].area();
 }
 
 float plate::getCrust(uint32_t x, uint32_t y) const
 {
-    const uint32_t index = _bounds->getMapIndex(&x, &y);
+    const uint32_t index = mapIndex(&x, &y);
     return index != BAD_INDEX ? map[index] : 0;
 }
 
 uint32_t plate::getCrustTimestamp(uint32_t x, uint32_t y) const
 {
-    const uint32_t index = _bounds->getMapIndex(&x, &y);
+    const uint32_t index = mapIndex(&x, &y);
     return index != BAD_INDEX ? age_map[index] : 0;
 }
 
@@ -532,9 +542,33 @@ void plate::move()
 }
 
 void plate::resetSegments()
+{
+    rebuildSegments(SEGMENTS_LAZY_FLOOD);
+}
+
+void plate::labelSegments()
+{
+    rebuildSegments(SEGMENTS_UNION_FIND);
+}
+
+void plate::rebuildSegments(Segmentation segmentation)
 {
     ASSERT(_bounds->area() == _segments->area(), "Segments doesn't have the expected area");
+    // Lookups of oceanic points add to the segments too, so these stay as
+    // a reset would leave them only if nothing was created since.
+    if (_ownSegments && _segmentsVersion == _crustVersion &&
+        _segmentsCreations == _mySegmentCreator->creations() &&
+        _segmentation == segmentation) {
+        _ownSegments->resetCollisions();
+        return;
+    }
     _segments->reset();
+    if (segmentation == SEGMENTS_UNION_FIND) {
+        _mySegmentCreator->createAllSegments();
+    }
+    _segmentsVersion = _crustVersion;
+    _segmentsCreations = _mySegmentCreator->creations();
+    _segmentation = segmentation;
 }
 
 void plate::setCrust(uint32_t x, uint32_t y, float z, uint32_t t)
@@ -545,7 +579,7 @@ void plate::setCrust(uint32_t x, uint32_t y, float z, uint32_t t)
 
     uint32_t _x = x;
     uint32_t _y = y;
-    uint32_t index = _bounds->getMapIndex(&_x, &_y);
+    uint32_t index = mapIndex(&_x, &_y);
 
     if (index == BAD_INDEX)
     {
@@ -595,40 +629,22 @@ void plate::setCrust(uint32_t x, uint32_t y, float z, uint32_t t)
         ASSERT(d_lft + d_rgt + d_top + d_btm != 0, "Invalid plate growth deltas");
 
         const uint32_t old_width  = _bounds->width();
-        const uint32_t old_height = _bounds->height();
+        ++_crustVersion;
 
         _bounds->shift(-1.0f*d_lft, -1.0f*d_top);
         _bounds->grow(d_lft + d_rgt, d_top + d_btm);
 
-        HeightMap tmph = HeightMap(_bounds->width(), _bounds->height());
-        AgeMap    tmpa = AgeMap(_bounds->width(), _bounds->height());
-        uint32_t* tmps = new uint32_t[_bounds->area()];
-        tmph.set_all(0);
-        tmpa.set_all(0);
-        memset(tmps, 255, _bounds->area()*sizeof(uint32_t));
-
-        // copy old plate into new.
-        for (uint32_t j = 0; j < old_height; ++j)
-        {
-            const uint32_t dest_i = (d_top + j) * _bounds->width() + d_lft;
-            const uint32_t src_i = j * old_width;
-            memcpy(&tmph[dest_i], &map[src_i], old_width *
-                   sizeof(float));
-            memcpy(&tmpa[dest_i], &age_map[src_i], old_width *
-                   sizeof(uint32_t));
-            memcpy(&tmps[dest_i], &_segments->id(src_i), old_width *
-                   sizeof(uint32_t));
-        }
-
-        map     = tmph;
-        age_map = tmpa;
-        _segments->reassign(_bounds->area(), tmps);
+        // Move the old plate into place within the new bounds.
+        map.grow(_bounds->width(), _bounds->height(), d_lft, d_top, 0.0f);
+        age_map.grow(_bounds->width(), _bounds->height(), d_lft, d_top, 0);
+        _segments->grow(old_width, _bounds->width(), _bounds->height(),
+                        d_lft, d_top);
 
         // Shift all segment data to match new coordinates.
         _segments->shift(d_lft, d_top);
 
         _x = x, _y = y;
-        index = _bounds->getValidMapIndex(&_x, &_y);
+        index = validMapIndex(&_x, &_y);
 
         assert(index < _bounds->area());
     }
@@ -649,13 +665,14 @@ void plate::setCrust(uint32_t x, uint32_t y, float z, uint32_t t)
 
     _mass.incMass(-1.0f * map[index]);
     _mass.incMass(z);      // Update mass counter.
+    _crustVersion += (map[index] >= CONT_BASE) != (z >= CONT_BASE);
     map[index] = z;     // Set new crust height to desired location.
 }
 
 ContinentId plate::selectCollisionSegment(uint32_t coll_x, uint32_t coll_y)
 {
-    uint32_t index = _bounds->getValidMapIndex(&coll_x, &coll_y);
-    ContinentId activeContinent = _segments->id(index);
+    uint32_t index = validMapIndex(&coll_x, &coll_y);
+    ContinentId activeContinent = segmentId(index);
     return activeContinent;
 }
 
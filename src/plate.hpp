@@ -31,6 +31,7 @@
 #include "movement.hpp"
 #include "mass.hpp"
 #include "segments.hpp"
+#include "plate_functions.hpp"
 
 class IPlate : public IMass, public IMovement
 {
@@ -59,8 +60,9 @@ public:
     ///
     /// @param  wx  X coordinate of collision point on world map.
     /// @param  wy  Y coordinate of collision point on world map.
+    /// @param[out] continent If not null, the id of the collided continent.
     /// @return Surface area of the collided continent (HACK!)
-    uint32_t addCollision(uint32_t wx, uint32_t wy);
+    uint32_t addCollision(uint32_t wx, uint32_t wy, ContinentId* continent = nullptr);
 
     /// Add crust to plate as result of continental collision.
     ///
@@ -133,7 +135,17 @@ public:
     /// Plates total mass and the center of mass are updated.
     ///
     /// @param  lower_bound Sets limit below which there's no erosion.
-    void erode(float lower_bound);
+    /// @param  routing     How the paths of rivers are found.
+    void erode(float lower_bound, RiverRouting routing = RIVERS_FRONTIER);
+
+    /// Apply one pass of thermal erosion, see smoothCrust().
+    ///
+    /// Plates total mass and the center of mass are updated.
+    ///
+    /// @param  lower_bound Sets limit below which crust doesn't slide.
+    /// @param  talus       Steepest slope that is left alone.
+    /// @param  rate        Part of the slope in excess of talus that slides.
+    void smooth(float lower_bound, float talus, float rate);
 
     /// Retrieve collision statistics of continent at given location.
     ///
@@ -185,8 +197,16 @@ public:
     /// To alleviate this problem without the need of per iteration
     /// recalculations plate supplies caller a method to reset its
     /// bookkeeping and start clean.
+    ///
+    /// If no point has turned continental or oceanic since the segments
+    /// were made they are still exact, so only their collision counts are
+    /// cleared.
     void resetSegments();
 
+    /// Reset the bookkeeping like resetSegments() and label every
+    /// continent right away with union-find instead of on lookup.
+    void labelSegments();
+
     /// Remember the currently processed continent's segment number.
     ///
     /// @param  coll_x  Origin of collision on global world map (X).
@@ -275,6 +295,7 @@ public:
     {
         delete _segments;
         _segments = segments;
+        _ownSegments = nullptr;
     }
 
     // Visible for testing
@@ -282,6 +303,7 @@ public:
     {
         delete _bounds;
         _bounds = bounds;
+        _ownBounds = nullptr;
     }
 
 private:
@@ -290,7 +312,35 @@ private:
     const ISegmentData& getContinentAt(int x, int y) const;
     void findRiverSources(float lower_bound, vector<uint32_t>* sources);
     void flowRivers(float lower_bound, vector<uint32_t>* sources, HeightMap& tmp);
+    void floodRivers(float lower_bound, const vector<uint32_t>& sources, HeightMap& tmp);
     uint32_t createSegment(uint32_t x, uint32_t y) throw();
+    void updatePaddedMap(); ///< Copy map into _paddedMap.
+    void rebuildSegments(Segmentation segmentation); ///< See resetSegments().
+
+    // The lookups of the per point loops. They go to the plate's own Bounds
+    // and Segments without a virtual call unless a test injected others.
+    uint32_t mapIndex(uint32_t* x, uint32_t* y) const
+    {
+        return _ownBounds ? _ownBounds->mapIndex(x, y) : _bounds->getMapIndex(x, y);
+    }
+    uint32_t validMapIndex(uint32_t* x, uint32_t* y) const
+    {
+        const uint32_t index = mapIndex(x, y);
+        ASSERT(index != BAD_INDEX, "BAD map index found");
+        return index;
+    }
+    ContinentId segmentId(uint32_t index) const
+    {
+        return _ownSegments ? _ownSegments->id(index) : _segments->id(index);
+    }
+    void setSegmentId(uint32_t index, ContinentId id)
+    {
+        if (_ownSegments) {
+            _ownSegments->setId(index, id);
+        } else {
+            _segments->setId(index, id);
+        }
+    }
 
     const WorldDimension _worldDimension;
     SimpleRandom _randsource;
@@ -300,7 +350,28 @@ private:
     Mass _mass;
     Movement _movement;
     ISegments* _segments;
+    Bounds* _ownBounds;       ///< _bounds until a test injects other bounds.
+    Segments* _ownSegments;   ///< _segments until a test injects others.
     MySegmentCreator* _mySegmentCreator;
+
+    /// Bumped when a point turns continental or oceanic, or when segments
+    /// are edited, so that resetSegments() can tell whether the segments
+    /// still describe the current continents.
+    uint32_t _crustVersion;
+    uint32_t _segmentsVersion;  ///< _crustVersion when segments were reset.
+    uint32_t _segmentsCreations; ///< Creator's creations() at that time.
+    Segmentation _segmentation; ///< How the current segments were made.
+
+    /// Scratch space of flowRivers(). Kept per plate, so that plates of
+    /// different worlds can be processed on different threads.
+    vector<bool> _flowDone;
+
+    /// Scratch space of floodRivers(), kept for the same reason.
+    FloodScratch _floodScratch;
+    vector<uint32_t> _floodUpstream;
+
+    /// Copy of map with a halo, for the neighbour lookups of erode().
+    PaddedMatrix<float> _paddedMap;
 };
 
 #endif
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include "plate_collisions.hpp"
+#include "rectangle.hpp" // BAD_INDEX
+
+void plateCollisions::groupByPlate(uint32_t num_plates)
+{
+    // Counting sort: count the records of each plate, turn the counts
+    // into the start of each plate's records, then place the records.
+    _starts.assign(num_plates + 1, 0);
+    for (uint32_t p : plate) {
+        ++_starts[p + 1];
+    }
+    for (uint32_t p = 1; p <= num_plates; ++p) {
+        _starts[p] += _starts[p - 1];
+    }
+    order.resize(plate.size());
+    for (uint32_t n = 0; n < plate.size(); ++n) {
+        order[_starts[plate[n]]++] = n;
+    }
+}
+
+void plateCollisions::sumByContinents(uint32_t num_plates)
+{
+    groupByPlate(num_plates);
+    pair_first.clear();
+    pair_crust.clear();
+
+    // The pairs of each plate are found with an open addressing hash table
+    // of pair numbers, at least twice as large as the plate's records.
+    for (uint32_t p = 0, begin = 0; p < num_plates; begin = _starts[p++])
+    {
+        const uint32_t end = _starts[p];
+        uint32_t mask = 1;
+        while (mask < 2 * (end - begin)) {
+            mask <<= 1;
+        }
+        --mask;
+        _slots.assign(mask + 1, BAD_INDEX);
+
+        for (uint32_t r = begin; r < end; ++r)
+        {
+            const uint32_t n = order[r];
+            uint32_t slot = pairHash(index[n], continent[n], other_continent[n]) & mask;
+            while (_slots[slot] != BAD_INDEX &&
+                    !samePair(pair_first[_slots[slot]], n)) {
+                slot = (slot + 1) & mask;
+            }
+            if (_slots[slot] == BAD_INDEX) {
+                _slots[slot] = pair_first.size();
+                pair_first.push_back(n);
+                pair_crust.push_back(0.0f);
+            }
+            pair_crust[_slots[slot]] += crust[n];
+        }
+    }
+}
+
+void plateCollisions::clear()
+{
+    plate.clear();
+    index.clear();
+    wx.clear();
+    wy.clear();
+    crust.clear();
+    continent.clear();
+    other_continent.clear();
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#ifndef PLATE_COLLISIONS_HPP
+#define PLATE_COLLISIONS_HPP
+
+#include <vector>
+#include "segment_creator.hpp" // ContinentId
+#include "utils.hpp"
+
+using namespace std;
+
+/**
+ * Collision details between two plates, of all plates in one step.
+ *
+ * In simulation there's usually 2-5 % collisions of the entire map
+ * area. In a 512*512 map that means 5000-13000 collisions. They are
+ * kept flat, one array per field, in the order they are recorded, and
+ * the arrays keep their capacity from step to step.
+ *
+ * When plate collisions are recorded and processed pair-by-pair, some
+ * of the information is lost if more than two plates collide at the
+ * same point (there will be no record of the two lower plates
+ * colliding together, just that they both collided with the tallest
+ * plate) ONLY IF ALL the collisions between ANY TWO plates of that
+ * group always include a third, taller/higher  plate. This happens
+ * most often when plates have long, sharp spikes i.e. in the
+ * beginning.
+ */
+class plateCollisions
+{
+public:
+    void add(uint32_t _plate, uint32_t _index, uint32_t x, uint32_t y,
+             float z, ContinentId _continent = 0, ContinentId _other_continent = 0)
+    {
+        ASSERT(z >= 0, "Crust must be a positive value");
+        plate.push_back(_plate);
+        index.push_back(_index);
+        wx.push_back(x);
+        wy.push_back(y);
+        crust.push_back(z);
+        continent.push_back(_continent);
+        other_continent.push_back(_other_continent);
+    }
+
+    /// Fill order with the records of plate 0 first, then those of
+    /// plate 1 and so on, each plate's records in recording order.
+    void groupByPlate(uint32_t num_plates);
+
+    /// Sum up the records between the same two continents into
+    /// pair_first and pair_crust, plate by plate and each plate's pairs
+    /// in the order of their first record.
+    void sumByContinents(uint32_t num_plates);
+
+    /// Hash of the continent pair of a record, see sumByContinents().
+    static uint32_t pairHash(uint32_t index, ContinentId continent,
+                             ContinentId other_continent)
+    {
+        return index * 0x9E3779B1u ^ continent * 0x85EBCA77u ^
+               other_continent * 0xC2B2AE3Du;
+    }
+
+    /// Both records are between the same two continents.
+    bool samePair(uint32_t a, uint32_t b) const
+    {
+        return plate[a] == plate[b] && index[a] == index[b] &&
+               continent[a] == continent[b] &&
+               other_continent[a] == other_continent[b];
+    }
+
+    void clear(); ///< Forget the records, keep the capacity.
+
+    vector<uint32_t> plate; ///< Index of the plate the record is for.
+    vector<uint32_t> index; ///< Index of the other plate involved in the event.
+    vector<uint32_t> wx, wy; ///< Coordinates of collision in world space.
+    vector<float> crust; ///< Amount of crust that will deform/subduct.
+    /// Continents of plate and of the other plate at the collision.
+    /// Only recorded for continental collisions.
+    vector<ContinentId> continent, other_continent;
+    vector<uint32_t> order; ///< Records by plate, see groupByPlate().
+    vector<uint32_t> pair_first; ///< First record of each pair.
+    vector<float> pair_crust; ///< Crust of all records of each pair.
+private:
+    vector<uint32_t> _starts; ///< Scratch space of groupByPlate().
+    vector<uint32_t> _slots; ///< Scratch space of sumByContinents().
+};
+
+#endif
@@ -18,6 +18,142 @@
  *****************************************************************************/
 
 #include "plate_functions.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+/// Crust that each point of a row gives to its west, east, north and south
+/// neighbours, and the change of its own height (usually a loss).
+static void computeOutflows(const float* __restrict above,
+                            const float* __restrict row,
+                            const float* __restrict below, uint32_t width,
+                            float lower_bound,
+                            float* __restrict to_w, float* __restrict to_e,
+                            float* __restrict to_n, float* __restrict to_s,
+                            float* __restrict self)
+{
+    const float* left = row - 1;
+    const float* right = row + 1;
+
+    for (uint32_t x = 0; x < width; ++x) {
+        const float crust = row[x];
+
+        // Lower neighbours, as in calculateCrust().
+        const float w_crust = left[x] < crust ? left[x] : 0.0f;
+        const float e_crust = right[x] < crust ? right[x] : 0.0f;
+        const float n_crust = above[x] < crust ? above[x] : 0.0f;
+        const float s_crust = below[x] < crust ? below[x] : 0.0f;
+
+        const float w_diff = crust - w_crust;
+        const float e_diff = crust - e_crust;
+        const float n_diff = crust - n_crust;
+        const float s_diff = crust - s_crust;
+
+        float min_diff = w_diff;
+        min_diff -= (min_diff - e_diff) * (e_diff < min_diff);
+        min_diff -= (min_diff - n_diff) * (n_diff < min_diff);
+        min_diff -= (min_diff - s_diff) * (s_diff < min_diff);
+
+        const float w_lower = w_crust > 0 ? 1.0f : 0.0f;
+        const float e_lower = e_crust > 0 ? 1.0f : 0.0f;
+        const float n_lower = n_crust > 0 ? 1.0f : 0.0f;
+        const float s_lower = s_crust > 0 ? 1.0f : 0.0f;
+
+        const float diff_sum = (w_diff - min_diff) * w_lower +
+                               (e_diff - min_diff) * e_lower +
+                               (n_diff - min_diff) * n_lower +
+                               (s_diff - min_diff) * s_lower;
+
+        // Not enough room in the neighbours: level them all with this
+        // point, then spread the rest equally among them and this point.
+        const bool level = diff_sum < min_diff;
+        const float rest = (min_diff - diff_sum) /
+                           (1 + w_lower + e_lower + n_lower + s_lower);
+        // Otherwise the point becomes as low as its tallest lower
+        // neighbour and the crust removed is spread in proportion.
+        const float unit = min_diff / (diff_sum > 0 ? diff_sum : 1.0f);
+
+        const float w_share = level ? w_diff - min_diff + rest : unit * (w_diff - min_diff);
+        const float e_share = level ? e_diff - min_diff + rest : unit * (e_diff - min_diff);
+        const float n_share = level ? n_diff - min_diff + rest : unit * (n_diff - min_diff);
+        const float s_share = level ? s_diff - min_diff + rest : unit * (s_diff - min_diff);
+
+        // Points too low or without lower neighbours keep their crust.
+        // Masks are multiplied rather than selected with branches, every
+        // value above is finite.
+        const float erodes = crust >= lower_bound &&
+                             w_crust + e_crust + n_crust + s_crust != 0 ? 1.0f : 0.0f;
+
+        to_w[x] = erodes * w_lower * w_share;
+        to_e[x] = erodes * e_lower * e_share;
+        to_n[x] = erodes * n_lower * n_share;
+        to_s[x] = erodes * s_lower * s_share;
+        self[x] = erodes * (level ? rest - min_diff : -min_diff);
+    }
+}
+
+void redistributeCrust(const PaddedMatrix<float>& heights, float lower_bound,
+                       bool wrap_x, bool wrap_y, float* out)
+{
+    const uint32_t width = heights.width();
+    const uint32_t height = heights.height();
+    const uint32_t row_size = width + 2;
+
+    // Outflows of the current row with a halo of one element on both
+    // sides, the south outflow of the row above and the north outflow of
+    // the first row, which goes to the last one when the plate wraps.
+    std::vector<float> buffer(7 * row_size, 0.0f);
+    float* to_w = buffer.data() + 1;
+    float* to_e = to_w + row_size;
+    float* to_n = to_e + row_size;
+    float* to_s = to_n + row_size;
+    float* self = to_s + row_size;
+    float* from_above = self + row_size;
+    float* first_to_n = from_above + row_size;
+
+    if (wrap_y) {
+        computeOutflows(heights.row(static_cast<int>(height) - 2),
+                        heights.row(height - 1),
+                        heights.row(height), width, lower_bound,
+                        to_w, to_e, to_n, from_above, self);
+    }
+
+    for (uint32_t y = 0; y < height; ++y) {
+        const float* row = heights.row(y);
+        computeOutflows(heights.row(static_cast<int>(y) - 1), row,
+                        heights.row(y + 1), width, lower_bound,
+                        to_w, to_e, to_n, to_s, self);
+        to_e[-1] = wrap_x ? to_e[width - 1] : 0.0f;
+        to_w[width] = wrap_x ? to_w[0] : 0.0f;
+
+        const float* from_w = to_e - 1;
+        const float* from_e = to_w + 1;
+        float* dest = out + y * width;
+        for (uint32_t x = 0; x < width; ++x) {
+            dest[x] = row[x] + self[x] + from_w[x] + from_e[x] + from_above[x];
+        }
+
+        if (y > 0) {
+            float* dest_above = dest - width;
+            for (uint32_t x = 0; x < width; ++x) {
+                dest_above[x] += to_n[x];
+            }
+        } else if (wrap_y) {
+            std::copy(to_n, to_n + width, first_to_n);
+        }
+
+        std::swap(from_above, to_s);
+    }
+
+    if (wrap_y) {
+        float* last = out + (height - 1) * width;
+        for (uint32_t x = 0; x < width; ++x) {
+            last[x] += first_to_n[x];
+        }
+    }
+}
 
 void calculateCrust(
     uint32_t x, uint32_t y,
@@ -75,3 +211,184 @@ void calculateCrust(
         throw runtime_error(msg.c_str());
     }
 }
+
+/// Crust that slides from a point of height from to its neighbour of
+/// height to, see smoothCrust().
+static inline float slide(float from, float to, float lower_bound,
+                          float talus, float rate)
+{
+    const float excess = from - to - talus;
+    const float moves = from >= lower_bound && excess > 0 ? 1.0f : 0.0f;
+    return moves * rate * excess;
+}
+
+void smoothCrust(const PaddedMatrix<float>& heights, float lower_bound,
+                 float talus, float rate, float* out)
+{
+    const uint32_t width = heights.width();
+    const uint32_t height = heights.height();
+    const float share = 0.25f * rate;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        const float* __restrict above = heights.row(static_cast<int>(y) - 1);
+        const float* __restrict row = heights.row(y);
+        const float* __restrict below = heights.row(y + 1);
+        const float* __restrict left = row - 1;
+        const float* __restrict right = row + 1;
+        float* __restrict dest = out + y * width;
+
+        for (uint32_t x = 0; x < width; ++x) {
+            const float crust = row[x];
+
+            // Nothing comes from the FLT_MAX outside of the plate.
+            const float w_in = left[x] < FLT_MAX ? slide(left[x], crust, lower_bound, talus, share) : 0.0f;
+            const float e_in = right[x] < FLT_MAX ? slide(right[x], crust, lower_bound, talus, share) : 0.0f;
+            const float n_in = above[x] < FLT_MAX ? slide(above[x], crust, lower_bound, talus, share) : 0.0f;
+            const float s_in = below[x] < FLT_MAX ? slide(below[x], crust, lower_bound, talus, share) : 0.0f;
+
+            const float out_flow = slide(crust, left[x], lower_bound, talus, share) +
+                                   slide(crust, right[x], lower_bound, talus, share) +
+                                   slide(crust, above[x], lower_bound, talus, share) +
+                                   slide(crust, below[x], lower_bound, talus, share);
+
+            dest[x] = crust + (w_in + e_in + n_in + s_in) - out_flow;
+        }
+    }
+}
+
+/// Heap key of a point flooded at the given level. The bits of a non
+/// negative float sort like the float, so keys sort by level then point.
+static inline uint64_t floodKey(float level, uint32_t index)
+{
+    const float positive = level > 0.0f ? level : 0.0f;
+    uint32_t bits;
+    memcpy(&bits, &positive, sizeof(bits));
+    return static_cast<uint64_t>(bits) << 32 | index;
+}
+
+void floodRivers(const HeightMap& heights, float lower_bound,
+                 bool wrap_x, bool wrap_y,
+                 const std::vector<uint32_t>& sources,
+                 std::vector<uint32_t>& upstream, FloodScratch& scratch)
+{
+    const std::greater<uint64_t> higher;
+    const uint32_t width = heights.width();
+    const uint32_t height = heights.height();
+    const uint32_t area = width * height;
+    const uint32_t unreached = UINT32_MAX;
+
+    std::vector<uint32_t>& receiver = scratch.receiver;
+    std::vector<uint64_t>& queue = scratch.queue;
+    std::vector<uint64_t>& pits = scratch.pits;
+    receiver.assign(area, unreached);
+    scratch.order.clear();
+    queue.clear();
+    pits.clear();
+
+    // Outlets drain into themselves. Only those next to land need to be
+    // flooded from, the others are never reached.
+    const auto isOutlet = [&](uint32_t x, uint32_t y) {
+        return (!wrap_x && (x == 0 || x + 1 == width)) ||
+               (!wrap_y && (y == 0 || y + 1 == height)) ||
+               heights[y * width + x] < lower_bound;
+    };
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t y_n = y > 0 ? y - 1 : height - 1;
+        const uint32_t y_s = y + 1 < height ? y + 1 : 0;
+        for (uint32_t x = 0; x < width; ++x) {
+            if (!isOutlet(x, y))
+                continue;
+
+            const uint32_t index = y * width + x;
+            const uint32_t x_w = x > 0 ? x - 1 : width - 1;
+            const uint32_t x_e = x + 1 < width ? x + 1 : 0;
+            receiver[index] = index;
+            if (!isOutlet(x_w, y) || !isOutlet(x_e, y) ||
+                !isOutlet(x, y_n) || !isOutlet(x, y_s)) {
+                queue.push_back(floodKey(heights[index], index));
+            }
+        }
+    }
+
+    // A plate covering the whole world with no low point: it drains into
+    // its lowest point.
+    if (queue.empty() && area > 0 && receiver[0] == unreached) {
+        const float* first = heights.raw_data();
+        const uint32_t lowest = static_cast<uint32_t>(
+            std::min_element(first, first + area) - first);
+        receiver[lowest] = lowest;
+        queue.push_back(floodKey(heights[lowest], lowest));
+    }
+    std::make_heap(queue.begin(), queue.end(), higher);
+
+    // Points in a pit don't need the heap: they are all flooded at the
+    // spill level of the pit, first come first served.
+    size_t next_pit = 0;
+    while (next_pit < pits.size() || !queue.empty()) {
+        uint64_t point;
+        if (next_pit < pits.size()) {
+            point = pits[next_pit++];
+            if (next_pit == pits.size()) {
+                pits.clear();
+                next_pit = 0;
+            }
+        } else {
+            std::pop_heap(queue.begin(), queue.end(), higher);
+            point = queue.back();
+            queue.pop_back();
+        }
+
+        const uint32_t index = static_cast<uint32_t>(point);
+        const uint32_t level_bits = static_cast<uint32_t>(point >> 32);
+        float level;
+        memcpy(&level, &level_bits, sizeof(level));
+        scratch.order.push_back(index);
+
+        const uint32_t y = index / width;
+        const uint32_t x = index - y * width;
+        uint32_t nbours[4];
+        uint32_t nbour_count = 0;
+        if (x > 0)
+            nbours[nbour_count++] = index - 1;
+        else if (wrap_x)
+            nbours[nbour_count++] = index + width - 1;
+        if (x + 1 < width)
+            nbours[nbour_count++] = index + 1;
+        else if (wrap_x)
+            nbours[nbour_count++] = index - x;
+        if (y > 0)
+            nbours[nbour_count++] = index - width;
+        else if (wrap_y)
+            nbours[nbour_count++] = index + (height - 1) * width;
+        if (y + 1 < height)
+            nbours[nbour_count++] = index + width;
+        else if (wrap_y)
+            nbours[nbour_count++] = x;
+
+        for (uint32_t i = 0; i < nbour_count; ++i) {
+            const uint32_t nbour = nbours[i];
+            if (receiver[nbour] != unreached)
+                continue;
+
+            receiver[nbour] = index;
+            if (heights[nbour] <= level) {
+                pits.push_back(floodKey(level, nbour));
+            } else {
+                queue.push_back(floodKey(heights[nbour], nbour));
+                std::push_heap(queue.begin(), queue.end(), higher);
+            }
+        }
+    }
+
+    // Every point is flooded after the point it drains into.
+    upstream.assign(area, 0);
+    for (uint32_t index : sources) {
+        ++upstream[index];
+    }
+    for (auto it = scratch.order.rbegin(); it != scratch.order.rend(); ++it) {
+        const uint32_t index = *it;
+        if (receiver[index] != index) {
+            upstream[receiver[index]] += upstream[index];
+        }
+    }
+}
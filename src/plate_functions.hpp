@@ -20,14 +20,95 @@
 #ifndef PLATE_FUNCTIONS_HPP
 #define PLATE_FUNCTIONS_HPP
 
+#include <vector>
 #include "utils.hpp"
 #include "rectangle.hpp"
 #include "heightmap.hpp"
 
+/// How plate::erode() finds the points that rivers flow through.
+enum RiverRouting
+{
+    /// Water flows from every peak to the lowest neighbour, one point per
+    /// pass, and stops in the first pit. The original method.
+    RIVERS_FRONTIER = 0,
+    /// Priority-flood: every point drains by steepest descent and pits are
+    /// filled, so rivers go on to the sea or to the edge of the plate.
+    RIVERS_PRIORITY_FLOOD,
+    RIVER_ROUTING_COUNT
+};
+
 void calculateCrust(uint32_t x, uint32_t y, uint32_t index,
                     float& w_crust, float& e_crust, float& n_crust, float& s_crust,
                     uint32_t& w, uint32_t& e, uint32_t& n, uint32_t& s,
                     const WorldDimension& worldDimension, HeightMap& map,
                     const uint32_t width, const uint32_t height);
 
+/// Second pass of plate::erode(): every point at least lower_bound high
+/// spreads crust to its lower 4-way neighbours.
+///
+/// The result is written to out (width x height, packed rows): for each
+/// point its height plus the crust it received minus the crust it gave.
+/// Instead of scattering into the neighbours point by point, what each
+/// point of a row gives to each side is computed first, then every point
+/// sums what came to it. Both steps run over whole rows without branches,
+/// so the compiler can vectorize them.
+///
+/// Compared to the point by point scatter it replaces, the amounts moved
+/// are the same but they are added up in another order. Each result may
+/// thus differ by rounding, at most 2^-20 (about 1e-6) relative to the
+/// height of the point. ErodeRedistribution tests hold it to that.
+///
+/// @param heights  Heights of the plate, with a halo as built by
+///                 plate::updatePaddedMap().
+/// @param wrap_x   The plate spans the world horizontally.
+/// @param wrap_y   The plate spans the world vertically.
+void redistributeCrust(const PaddedMatrix<float>& heights, float lower_bound,
+                       bool wrap_x, bool wrap_y, float* out);
+
+/// Single pass of thermal erosion: crust slides down every slope steeper
+/// than talus between 4-way neighbours.
+///
+/// Each pair of neighbours exchanges rate / 4 of the height difference in
+/// excess of talus, from the higher point to the lower one, if the higher
+/// point is at least lower_bound high. A point thus loses at most rate of
+/// its excess, and crust is only moved, never created or destroyed.
+///
+/// @param heights  Heights of the plate, with a halo as built by
+///                 plate::updatePaddedMap(): FLT_MAX marks the points
+///                 outside the plate.
+/// @param out      Result, width x height packed rows.
+void smoothCrust(const PaddedMatrix<float>& heights, float lower_bound,
+                 float talus, float rate, float* out);
+
+/// Buffers of floodRivers(), kept between calls to avoid reallocations.
+class FloodScratch
+{
+public:
+    std::vector<uint32_t> receiver; ///< Point each point drains into.
+    std::vector<uint32_t> order; ///< Points in the order they were flooded.
+    std::vector<uint64_t> queue; ///< Heap of points by flooding level.
+    std::vector<uint64_t> pits; ///< Points below their spill level.
+};
+
+/// Count for every point of a plate the river sources draining through it.
+///
+/// The plate is flooded from its outlets, points lower than lower_bound
+/// and the edges that don't wrap around the world, always continuing
+/// from the lowest point reached so far (priority-flood). Each point
+/// drains into the neighbour it was reached from: its lowest neighbour,
+/// or for points in a pit the way out of the pit. Walking the points in
+/// reverse flooding order then adds up the sources upstream of each
+/// point. Takes O(n log n) time for n points.
+///
+/// @param heights  Heights of the plate, width x height packed rows.
+/// @param sources  Points where rivers start, see plate::erode().
+/// @param wrap_x   The plate spans the world horizontally.
+/// @param wrap_y   The plate spans the world vertically.
+/// @param[out] upstream Number of sources upstream of each point,
+///                      the point itself included.
+void floodRivers(const HeightMap& heights, float lower_bound,
+                 bool wrap_x, bool wrap_y,
+                 const std::vector<uint32_t>& sources,
+                 std::vector<uint32_t>& upstream, FloodScratch& scratch);
+
 #endif
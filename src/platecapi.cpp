@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <mutex>
 #include <vector>
 
 class platec_api_list_elem
@@ -37,6 +38,8 @@ public:
 
 extern lithosphere* platec_api_get_lithosphere(uint32_t);
 
+// Worlds may be created and destroyed from different threads.
+static std::mutex lithospheres_mutex;
 static std::vector<platec_api_list_elem> lithospheres;
 static uint32_t last_id = 1;
 
@@ -44,15 +47,27 @@ static uint32_t last_id = 1;
 void* platec_api_create(long seed, uint32_t width, uint32_t height, float sea_level,
                         uint32_t erosion_period, float folding_ratio,
                         uint32_t aggr_overlap_abs, float aggr_overlap_rel,
-                        uint32_t cycle_count, uint32_t num_plates)
+                        uint32_t cycle_count, uint32_t num_plates,
+                        uint32_t num_threads,
+                        uint32_t erosion_strategy, uint32_t erosion_schedule)
 {
     /* Miten nykyisen opengl-mainin koodit refaktoroidaan tänne?
      *    parametrien tarkistus, kommentit eli dokumentointi, muuta? */
 
+    IErosion* erosion = createErosion(erosion_strategy);
+    if (!erosion || erosion_schedule >= EROSION_SCHEDULE_COUNT) {
+        delete erosion;
+        return nullptr;
+    }
+
     lithosphere* litho = new lithosphere(seed, width, height, sea_level,
                                          erosion_period, folding_ratio, aggr_overlap_abs,
-                                         aggr_overlap_rel, cycle_count, num_plates);
+                                         aggr_overlap_rel, cycle_count, num_plates,
+                                         num_threads);
+    litho->setErosion(erosion);
+    litho->setErosionSchedule(static_cast<ErosionSchedule>(erosion_schedule));
 
+    std::lock_guard<std::mutex> lock(lithospheres_mutex);
     platec_api_list_elem elem(++last_id, litho);
     lithospheres.push_back(elem);
 
@@ -61,6 +76,7 @@ void* platec_api_create(long seed, uint32_t width, uint32_t height, float sea_le
 
 void platec_api_destroy(void* litho)
 {
+    std::lock_guard<std::mutex> lock(lithospheres_mutex);
     for (uint32_t i = 0; i < lithospheres.size(); ++i)
         if (lithospheres[i].data == litho) {
             lithospheres.erase(lithospheres.begin()+i);
@@ -93,6 +109,7 @@ uint32_t* platec_api_get_platesmap(void *pointer)
 
 lithosphere* platec_api_get_lithosphere(uint32_t id)
 {
+    std::lock_guard<std::mutex> lock(lithospheres_mutex);
     for (uint32_t i = 0; i < lithospheres.size(); ++i)
         if (lithospheres[i].id == id)
             return lithospheres[i].data;
@@ -126,6 +143,36 @@ uint32_t lithosphere_getMapHeight ( void* object)
     return static_cast<lithosphere*>( object)->getHeight();
 }
 
+uint32_t platec_api_set_river_routing(void* pointer, uint32_t routing)
+{
+    if (routing >= RIVER_ROUTING_COUNT)
+        return 0;
+
+    lithosphere* litho = static_cast<lithosphere*>(pointer);
+    litho->setRiverRouting(static_cast<RiverRouting>(routing));
+    return 1;
+}
+
+uint32_t platec_api_set_segmentation(void* pointer, uint32_t segmentation)
+{
+    if (segmentation >= SEGMENTATION_COUNT)
+        return 0;
+
+    lithosphere* litho = static_cast<lithosphere*>(pointer);
+    litho->setSegmentation(static_cast<Segmentation>(segmentation));
+    return 1;
+}
+
+uint32_t platec_api_set_collision_resolution(void* pointer, uint32_t resolution)
+{
+    if (resolution >= COLLISION_RESOLUTION_COUNT)
+        return 0;
+
+    lithosphere* litho = static_cast<lithosphere*>(pointer);
+    litho->setCollisionResolution(static_cast<CollisionResolution>(resolution));
+    return 1;
+}
+
 float platec_api_velocity_unity_vector_x(void* pointer, uint32_t plate_index)
 {
     lithosphere* litho = static_cast<lithosphere*>(pointer);
@@ -137,3 +184,39 @@ float platec_api_velocity_unity_vector_y(void* pointer, uint32_t plate_index)
     lithosphere* litho = static_cast<lithosphere*>(pointer);
     return litho->getPlate(plate_index)->velocityUnitVector().y();
 }
+
+uint32_t platec_api_get_phase_count()
+{
+    return PHASE_COUNT;
+}
+
+const char* platec_api_get_phase_name(uint32_t phase)
+{
+    return phaseName(phase);
+}
+
+uint32_t platec_api_get_phase_stats(void* pointer, uint64_t* calls, double* seconds)
+{
+#ifdef PLATEC_PHASE_STATS
+    lithosphere* litho = static_cast<lithosphere*>(pointer);
+    for (uint32_t i = 0; i < PHASE_COUNT; ++i) {
+        const PhaseStats& stats = litho->getPhaseStats(i);
+        if (calls)
+            calls[i] = stats.calls;
+        if (seconds)
+            seconds[i] = stats.seconds;
+    }
+    return PHASE_COUNT;
+#else
+    (void)pointer;
+    (void)calls;
+    (void)seconds;
+    return 0;
+#endif
+}
+
+void platec_api_reset_phase_stats(void* pointer)
+{
+    lithosphere* litho = static_cast<lithosphere*>(pointer);
+    litho->resetPhaseStats();
+}
@@ -23,6 +23,9 @@
 #include <string.h> // For size_t.
 #include "utils.hpp"
 
+// erosion_strategy: 0 rivers (default), 1 thermal smoothing, a cheap preview.
+// erosion_schedule: 0 every erosion_period steps (default), 1 only at the
+// end of each cycle. Return nullptr if either is unknown.
 void *  platec_api_create(
     long seed,
     uint32_t width,
@@ -30,7 +33,9 @@ void *  platec_api_create(
     float sea_level,
     uint32_t erosion_period, float folding_ratio,
     uint32_t aggr_overlap_abs, float aggr_overlap_rel,
-    uint32_t cycle_count, uint32_t num_plates);
+    uint32_t cycle_count, uint32_t num_plates,
+    uint32_t num_threads = 1,
+    uint32_t erosion_strategy = 0, uint32_t erosion_schedule = 0);
 
 void    platec_api_destroy(void*);
 const uint32_t* platec_api_get_agemap(uint32_t);
@@ -45,4 +50,30 @@ float platec_api_velocity_unity_vector_y(void*, uint32_t plate_index);
 uint32_t lithosphere_getMapWidth ( void* object);
 uint32_t lithosphere_getMapHeight ( void* object);
 
+// How erosion finds the paths of rivers: 0 for the original frontier
+// method (default), 1 for priority-flood routing. See RiverRouting.
+// Return 0 and leave the world unchanged if routing is unknown.
+uint32_t platec_api_set_river_routing(void*, uint32_t routing);
+
+// How plates find their continents: 0 for a flood fill on first lookup
+// (default), 1 for labelling them all at once with union-find. See
+// Segmentation. Return 0 and leave the world unchanged if unknown.
+uint32_t platec_api_set_segmentation(void*, uint32_t segmentation);
+
+// How continental collisions are handled: 0 point by point (default), 1 once
+// per pair of collided continents. See CollisionResolution. Return 0 and
+// leave the world unchanged if unknown.
+uint32_t platec_api_set_collision_resolution(void*, uint32_t resolution);
+
+// Per-phase profile of platec_api_step(). Only collected when the library is
+// built with PLATEC_PHASE_STATS (CMake option WITH_PHASE_STATS).
+uint32_t    platec_api_get_phase_count();
+const char* platec_api_get_phase_name(uint32_t phase);
+
+// Fill calls and seconds, both arrays of platec_api_get_phase_count()
+// entries. Return the number of phases written: 0 if the profile was
+// compiled out.
+uint32_t platec_api_get_phase_stats(void*, uint64_t* calls, double* seconds);
+void     platec_api_reset_phase_stats(void*);
+
 #endif
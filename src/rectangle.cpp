@@ -28,8 +28,8 @@ uint32_t Rectangle::getMapIndex(uint32_t* px, uint32_t* py) const
 {
     uint32_t world_width = _worldDimension.getWidth();
     uint32_t world_height = _worldDimension.getHeight();
-    uint32_t x = *px % world_width;
-    uint32_t y = *py % world_height;
+    uint32_t x = *px < world_width ? *px : *px % world_width;
+    uint32_t y = *py < world_height ? *py : *py % world_height;
 
     const uint32_t ilft = (uint32_t)(int)_left;
     const uint32_t itop = (uint32_t)(int)_top;
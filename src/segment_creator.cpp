@@ -92,6 +92,7 @@ ContinentId MySegmentCreator::createSegment(uint32_t x, uint32_t y) const throw(
     if (_segments->id(origin_index) < ID) {
         return _segments->id(origin_index);
     }
+    ++_creations;
 
     uint32_t nbour_id = calcDirection(x, y, origin_index, ID);
 
@@ -107,19 +108,14 @@ ContinentId MySegmentCreator::createSegment(uint32_t x, uint32_t y) const throw(
 
     uint32_t lines_processed;
     Platec::Rectangle rect(_worldDimension, x, x, y, y);
-    SegmentData* pData = new SegmentData(rect, 0);
-    static vector<vector<uint32_t> > spans_todo;
-    static vector<vector<uint32_t> > spans_done;
-    static uint32_t spans_size = 0;
+    SegmentData data(rect, 0);
     // MK: This code was originally allocating the 2D arrays per function call.
     // This was eating up a tremendous amount of cpu.
-    // They are now static and they grow as needed, which turns out to be seldom.
-    if (spans_size < bounds_height) {
-        spans_todo.clear();
-        spans_done.clear();
+    // They are now kept by the creator and they grow as needed, which turns
+    // out to be seldom.
+    if (spans_todo.size() < bounds_height) {
         spans_todo.resize(bounds_height);
         spans_done.resize(bounds_height);
-        spans_size = bounds_height;
     }
     _segments->setId(origin_index, ID);
     spans_todo[y].push_back(x);
@@ -193,13 +189,13 @@ ContinentId MySegmentCreator::createSegment(uint32_t x, uint32_t y) const throw(
                 // Count volume of pixel...
             }
 
-            pData->incArea(1 + end - start); // Update segment area counter.
+            data.incArea(1 + end - start); // Update segment area counter.
 
             // Record any changes in extreme dimensions.
-            if (line < pData->getTop()) pData->setTop(line);
-            if (line > pData->getBottom()) pData->setBottom(line);
-            if (start < pData->getLeft()) pData->setLeft(start);
-            if (end > pData->getRight()) pData->setRight(end);
+            if (line < data.getTop()) data.setTop(line);
+            if (line > data.getBottom()) data.setBottom(line);
+            if (start < data.getLeft()) data.setLeft(start);
+            if (end > data.getRight()) data.setRight(end);
 
             if (line > 0 || bounds_height == _worldDimension.getHeight()) {
                 for (uint32_t j = start; j <= end; ++j)
@@ -265,7 +261,107 @@ ContinentId MySegmentCreator::createSegment(uint32_t x, uint32_t y) const throw(
         spans_todo[line].clear();
         spans_done[line].clear();
     }
-    _segments->add(pData);
+    _segments->add(data);
 
     return ID;
 }
+
+// Root of the set of point i, halving the path to it on the way.
+static uint32_t findRoot(std::vector<uint32_t>& parents, uint32_t i)
+{
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+// Join the sets of points a and b under the smaller of the two roots.
+static void unite(std::vector<uint32_t>& parents, uint32_t a, uint32_t b)
+{
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if (a < b) {
+        parents[b] = a;
+    } else {
+        parents[a] = b;
+    }
+}
+
+void MySegmentCreator::createAllSegments() const
+{
+    const uint32_t bounds_width = _bounds.width();
+    const uint32_t bounds_height = _bounds.height();
+    const uint32_t area = bounds_width * bounds_height;
+    const bool wrap_x = bounds_width == _worldDimension.getWidth();
+    const bool wrap_y = bounds_height == _worldDimension.getHeight();
+    const uint32_t none = static_cast<uint32_t>(-1);
+    ASSERT(_segments->size() == 0, "Segments must be reset first");
+
+    // First pass: join every continental point with its continental
+    // neighbours on the left and above.
+    parents.resize(area);
+    for (uint32_t y = 0, i = 0; y < bounds_height; ++y) {
+        for (uint32_t x = 0; x < bounds_width; ++x, ++i) {
+            if (map[i] < CONT_BASE) {
+                parents[i] = none;
+                continue;
+            }
+            parents[i] = i;
+            if (x > 0 && parents[i - 1] != none) {
+                unite(parents, i, i - 1);
+            }
+            if (y > 0 && parents[i - bounds_width] != none) {
+                unite(parents, i, i - bounds_width);
+            }
+        }
+    }
+    if (wrap_x) {
+        for (uint32_t i = 0; i < area; i += bounds_width) {
+            if (parents[i] != none && parents[i + bounds_width - 1] != none) {
+                unite(parents, i, i + bounds_width - 1);
+            }
+        }
+    }
+    if (wrap_y) {
+        const uint32_t last_line = area - bounds_width;
+        for (uint32_t x = 0; x < bounds_width; ++x) {
+            if (parents[x] != none && parents[last_line + x] != none) {
+                unite(parents, x, last_line + x);
+            }
+        }
+    }
+
+    // Point every point straight at its root. Roots are the first point of
+    // their set as unite() keeps the smaller one.
+    for (uint32_t i = 0; i < area; ++i) {
+        if (parents[i] != none) {
+            parents[i] = findRoot(parents, i);
+        }
+    }
+
+    // Second pass: number the sets in the order of their first point and
+    // give each point the segment of its set. A root, once numbered, holds
+    // area + its segment.
+    for (uint32_t y = 0, i = 0; y < bounds_height; ++y) {
+        for (uint32_t x = 0; x < bounds_width; ++x, ++i) {
+            const uint32_t root = parents[i];
+            if (root == none) {
+                continue;
+            }
+            ContinentId id;
+            if (root == i) {
+                id = _segments->size();
+                Platec::Rectangle rect(_worldDimension, x, x, y, y);
+                _segments->add(SegmentData(rect, 0));
+                parents[i] = area + id;
+            } else {
+                id = parents[root] - area;
+            }
+            _segments->setId(i, id);
+            ISegmentData& data = (*_segments)[id];
+            data.incArea();
+            data.enlarge_to_contain(x, y);
+        }
+    }
+}
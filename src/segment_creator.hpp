@@ -26,8 +26,21 @@
 
 typedef uint32_t ContinentId;
 
-class IBounds;
-class ISegments;
+/// How a plate finds its continents after its segments are reset.
+enum Segmentation
+{
+    /// Each continent is flood filled the first time one of its points is
+    /// looked up. The original method.
+    SEGMENTS_LAZY_FLOOD = 0,
+    /// Every continent is labelled right after the reset by a two pass
+    /// connected components labelling with union-find. Later lookups only
+    /// read the labels.
+    SEGMENTS_UNION_FIND,
+    SEGMENTATION_COUNT
+};
+
+class Bounds;
+class Segments;
 
 class ISegmentCreator
 {
@@ -38,9 +51,10 @@ public:
 class MySegmentCreator : public ISegmentCreator
 {
 public:
-    MySegmentCreator(IBounds& bounds, ISegments* segments, HeightMap& map_,
+    MySegmentCreator(Bounds& bounds, Segments* segments, HeightMap& map_,
                      const WorldDimension& worldDimension)
-        : _worldDimension(worldDimension), _bounds(bounds), _segments(segments), map(map_)
+        : _worldDimension(worldDimension), _bounds(bounds), _segments(segments), map(map_),
+          _creations(0)
     {
 
     }
@@ -54,14 +68,37 @@ public:
     /// @param	y	Offset on the local height map along Y axis.
     /// @return	ID of created segment on success, otherwise -1.
     ContinentId createSegment(uint32_t wx, uint32_t wy) const throw() override;
+
+    /// Label every continent of a plate without any segments yet.
+    ///
+    /// Continental points 4-ways adjacent to each other, across the world
+    /// edges where the plate spans the whole world, get the same segment.
+    /// Segments are numbered in the order of their first point.
+    void createAllSegments() const;
+
+    /// Number of createSegment() calls that created or grew a segment
+    /// rather than only finding one.
+    uint32_t creations() const
+    {
+        return _creations;
+    }
 private:
     uint32_t calcDirection(uint32_t x, uint32_t y, const uint32_t origin_index, const uint32_t ID) const;
     void scanSpans(const uint32_t line, uint32_t& start, uint32_t& end,
                    std::vector<uint32_t>* spans_todo, std::vector<uint32_t>* spans_done) const;
     const WorldDimension _worldDimension;
-    IBounds& _bounds;
-    ISegments* _segments;
+    Bounds& _bounds;      ///< Concrete, so the span scans inline their
+    Segments* _segments;  ///< lookups.
     HeightMap& map;
+    mutable uint32_t _creations;
+
+    // Scratch space of createSegment(), one list of spans per line.
+    mutable std::vector<std::vector<uint32_t> > spans_todo;
+    mutable std::vector<std::vector<uint32_t> > spans_done;
+
+    // Scratch space of createAllSegments(): union-find parent of each
+    // point, then the segment of each root.
+    mutable std::vector<uint32_t> parents;
 };
 
 #endif
@@ -83,6 +83,11 @@ void SegmentData::incCollCount()
     _coll_count++;
 };
 
+void SegmentData::resetCollCount()
+{
+    _coll_count = 0;
+};
+
 void SegmentData::incArea()
 {
     _area++;
@@ -41,6 +41,7 @@ class ISegmentData : public ISegmentDataAccess
 public:
     ~ISegmentData() override = default;
     virtual void incCollCount() = 0;
+    virtual void resetCollCount() = 0;
     virtual void incArea() = 0;
     virtual void enlarge_to_contain(uint32_t x, uint32_t y) = 0;
     virtual void markNonExistent() = 0;
@@ -48,7 +49,7 @@ public:
 };
 
 /// Container for details about a segmented crust area on this plate.
-class SegmentData : public ISegmentData
+class SegmentData final : public ISegmentData
 {
 public:
     SegmentData(const Platec::Rectangle& rectangle,
@@ -66,6 +67,7 @@ public:
     void setBottom(uint32_t v);
     bool isEmpty() const override;
     void incCollCount() override;
+    void resetCollCount() override;
     void incArea() override;
     void incArea(uint32_t amount);
     uint32_t area() const override;
@@ -22,6 +22,7 @@
 Segments::Segments(uint32_t plate_area)
 {
     _area = plate_area;
+    _capacity = plate_area;
     segment = new uint32_t[plate_area];
     memset(segment, 255, plate_area * sizeof(uint32_t));
 }
@@ -31,9 +32,6 @@ Segments::~Segments()
     delete[] segment;
     segment = nullptr;
     _area = 0;
-    for (size_t i = 0; i < seg_data.size(); i++) {
-        delete seg_data[i];
-    }
 }
 
 uint32_t Segments::area()
@@ -44,24 +42,43 @@ uint32_t Segments::area()
 void Segments::reset()
 {
     memset(segment, -1, sizeof(uint32_t) * _area);
+    seg_data.clear();
+}
+
+void Segments::resetCollisions()
+{
     for (size_t i = 0; i < seg_data.size(); i++) {
-        delete seg_data[i];
+        seg_data[i].resetCollCount();
     }
-    seg_data.clear();
 }
 
-void Segments::reassign(uint32_t newarea, uint32_t* tmps)
+void Segments::grow(uint32_t old_width, uint32_t width, uint32_t height,
+                    uint32_t d_lft, uint32_t d_top)
 {
-    delete[] segment;
-    _area = newarea;
-    segment = tmps;
+    const uint32_t old_height = _area / old_width;
+    const uint32_t area = width * height;
+    const ContinentId none = static_cast<ContinentId>(-1);
+
+    if (area > _capacity) {
+        const uint32_t capacity = grownCapacity(area);
+        ContinentId* ids = new ContinentId[capacity];
+        growRows(segment, ids, old_width, old_height, width, height,
+                 d_lft, d_top, none);
+        delete[] segment;
+        segment = ids;
+        _capacity = capacity;
+    } else {
+        growRows(segment, segment, old_width, old_height, width, height,
+                 d_lft, d_top, none);
+    }
+    _area = area;
 }
 
 void Segments::shift(uint32_t d_lft, uint32_t d_top)
 {
     for (uint32_t s = 0; s < seg_data.size(); ++s)
     {
-        seg_data[s]->shift(d_lft, d_top);
+        seg_data[s].shift(d_lft, d_top);
     }
 }
 
@@ -73,16 +90,16 @@ uint32_t Segments::size() const
 const ISegmentData& Segments::operator[](uint32_t index) const
 {
     ASSERT(index < seg_data.size(), "Invalid index");
-    return *seg_data[index];
+    return seg_data[index];
 }
 
 ISegmentData& Segments::operator[](uint32_t index)
 {
     ASSERT(index < seg_data.size(), "Invalid index");
-    return *seg_data[index];
+    return seg_data[index];
 }
 
-void Segments::add(ISegmentData* data) {
+void Segments::add(const SegmentData& data) {
     seg_data.push_back(data);
 }
 
@@ -40,12 +40,15 @@ public:
     virtual ~ISegments() {}
     virtual uint32_t area() = 0;
     virtual void reset() = 0;
-    virtual void reassign(uint32_t newarea, uint32_t* tmps) = 0;
+    /// Follow the growth of the plate to width x height: the ids of the
+    /// old_width wide map move by (d_lft, d_top), new locations get none.
+    virtual void grow(uint32_t old_width, uint32_t width, uint32_t height,
+                      uint32_t d_lft, uint32_t d_top) = 0;
     virtual void shift(uint32_t d_lft, uint32_t d_top) = 0;
     virtual uint32_t size() const = 0;
     virtual const ISegmentData& operator[](uint32_t index) const = 0;
     virtual ISegmentData& operator[](uint32_t index) = 0;
-    virtual void add(ISegmentData* data) = 0;
+    virtual void add(const SegmentData& data) = 0;
     // Continent at the give world index
     virtual const ContinentId& id(uint32_t index) const = 0;
     // Continent at the give world index
@@ -54,7 +57,9 @@ public:
     virtual ContinentId getContinentAt(int x, int y) const = 0;
 };
 
-class Segments : public ISegments
+/// Final, so that code holding a Segments rather than an ISegments calls
+/// and inlines id() and setId() directly.
+class Segments final : public ISegments
 {
 public:
     explicit Segments(uint32_t plate_area);
@@ -63,18 +68,21 @@ public:
     {
         _segmentCreator = segmentCreator;
     }
-    void setBounds(IBounds* bounds)
+    void setBounds(Bounds* bounds)
     {
         _bounds = bounds;
     }
     uint32_t area() override;
     void reset() override;
-    void reassign(uint32_t newarea, uint32_t* tmps) override;
+    /// Forget the collisions counted so far but keep the segments.
+    void resetCollisions();
+    void grow(uint32_t old_width, uint32_t width, uint32_t height,
+              uint32_t d_lft, uint32_t d_top) override;
     void shift(uint32_t d_lft, uint32_t d_top) override;
     uint32_t size() const override;
     const ISegmentData& operator[](uint32_t index) const override;
     ISegmentData& operator[](uint32_t index) override;
-    void add(ISegmentData* data) override;
+    void add(const SegmentData& data) override;
     const ContinentId& id(uint32_t index) const override {
         return segment[index];
     }
@@ -86,11 +94,14 @@ public:
     }
     ContinentId getContinentAt(int x, int y) const override;
 private:
-    std::vector<ISegmentData*> seg_data; ///< Details of each crust segment.
+    /// Details of each crust segment. Held by value and only truncated on
+    /// reset(), so that steady state segmentation doesn't allocate.
+    std::vector<SegmentData> seg_data;
     ContinentId* segment;              ///< Segment ID of each piece of continental crust.
     int _area; /// Should be the same as the bounds area of the plate
+    uint32_t _capacity; ///< Number of ids segment can hold.
     ISegmentCreator* _segmentCreator;
-    IBounds* _bounds;
+    Bounds* _bounds;
 };
 
 #endif
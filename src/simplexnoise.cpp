@@ -24,7 +24,9 @@
 #undef __STRICT_ANSI__
 #endif
 #include <math.h>
+#include <algorithm>
 #include <cstdlib>
+#include <vector>
 
 #include "simplexnoise.hpp"
 
@@ -521,6 +523,437 @@ float raw_noise_4d(const float x, const float y, const float z, const float w) {
     return (float)(27.0 * (n0 + n1 + n2 + n3 + n4));
 }
 
+// Points processed together by the batch functions.
+static const int NOISE_LANES = 8;
+
+// The lane kernels are plain C++ the compiler vectorizes. Where the loader
+// can pick a function version at run time (GCC on x86-64 Linux), they are
+// also built for AVX2 and SSE4.1 and the best one the CPU supports is used.
+// Neither enables FMA, so no version contracts a multiply and an add and all
+// give the same bits. On AArch64, NEON is always there and the default
+// build uses it.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define NOISE_KERNEL __attribute__((target_clones("avx2", "sse4.1", "default")))
+#else
+#define NOISE_KERNEL
+#endif
+
+// 2D raw Simplex noise of exactly NOISE_LANES points.
+//
+// The same operations as raw_noise_2d(), in the same order and precision,
+// so the results are the same bit for bit. Lookups in the tables are done
+// point by point, the arithmetic around them lane by lane in loops the
+// compiler can vectorize.
+NOISE_KERNEL static void raw_noise_2d_lanes(const float* x, const float* y, float* out)
+{
+    const float F2 = (float)(0.5 * (sqrtf(3.0) - 1.0));
+    const float G2 = (float)((3.0 - sqrtf(3.0)) / 6.0);
+
+    int i[NOISE_LANES], j[NOISE_LANES];
+    float x0[NOISE_LANES], y0[NOISE_LANES];
+
+    // Cell and position in the cell, as in raw_noise_2d().
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float s = (x[n] + y[n]) * F2;
+        const float xs = x[n] + s;
+        const float ys = y[n] + s;
+        i[n] = xs > 0 ? (int)xs : (int)xs - 1;
+        j[n] = ys > 0 ? (int)ys : (int)ys - 1;
+        const float t = (i[n] + j[n]) * G2;
+        x0[n] = x[n] - (i[n] - t);
+        y0[n] = y[n] - (j[n] - t);
+    }
+
+    // Offset of the middle corner and gradients of all three, per
+    // coordinate. Small integers, exact as floats.
+    float offset[2][NOISE_LANES];
+    float grad[3][2][NOISE_LANES];
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const int i1 = x0[n] > y0[n] ? 1 : 0;
+        const int j1 = 1 - i1;
+        offset[0][n] = (float)i1;
+        offset[1][n] = (float)j1;
+
+        const int ii = i[n] & 255;
+        const int jj = j[n] & 255;
+        const int gi[3] = {
+            perm[ii + perm[jj]] % 12,
+            perm[ii + i1 + perm[jj + j1]] % 12,
+            perm[ii + 1 + perm[jj + 1]] % 12
+        };
+        for (int m = 0; m < 3; ++m) {
+            grad[m][0][n] = (float)grad3[gi[m]][0];
+            grad[m][1][n] = (float)grad3[gi[m]][1];
+        }
+    }
+
+    // Contributions of the three corners.
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float x1 = x0[n] - offset[0][n] + G2;
+        const float y1 = y0[n] - offset[1][n] + G2;
+        const float x2 = (float)(x0[n] - 1.0 + 2.0 * G2);
+        const float y2 = (float)(y0[n] - 1.0 + 2.0 * G2);
+
+        float t0 = (float)(0.5 - x0[n]*x0[n] - y0[n]*y0[n]);
+        float t1 = (float)(0.5 - x1*x1 - y1*y1);
+        float t2 = (float)(0.5 - x2*x2 - y2*y2);
+        const bool in0 = !(t0 < 0);
+        const bool in1 = !(t1 < 0);
+        const bool in2 = !(t2 < 0);
+        t0 *= t0;
+        t1 *= t1;
+        t2 *= t2;
+
+        const float dot0 = grad[0][0][n] * x0[n] + grad[0][1][n] * y0[n];
+        const float dot1 = grad[1][0][n] * x1 + grad[1][1][n] * y1;
+        const float dot2 = grad[2][0][n] * x2 + grad[2][1][n] * y2;
+
+        const float n0 = in0 ? t0 * t0 * dot0 : 0.0f;
+        const float n1 = in1 ? t1 * t1 * dot1 : 0.0f;
+        const float n2 = in2 ? t2 * t2 * dot2 : 0.0f;
+        out[n] = (float)(70.0 * (n0 + n1 + n2));
+    }
+}
+
+// 3D raw Simplex noise of exactly NOISE_LANES points, see raw_noise_2d_lanes().
+NOISE_KERNEL static void raw_noise_3d_lanes(const float* x, const float* y, const float* z,
+                                            float* out)
+{
+    const float F3 = (float)(1.0 / 3.0);
+    const float G3 = (float)(1.0 / 6.0);
+
+    int i[NOISE_LANES], j[NOISE_LANES], k[NOISE_LANES];
+    float x0[NOISE_LANES], y0[NOISE_LANES], z0[NOISE_LANES];
+
+    // Cell and position in the cell, as in raw_noise_3d().
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float s = (x[n] + y[n] + z[n]) * F3;
+        const float xs = x[n] + s;
+        const float ys = y[n] + s;
+        const float zs = z[n] + s;
+        i[n] = xs > 0 ? (int)xs : (int)xs - 1;
+        j[n] = ys > 0 ? (int)ys : (int)ys - 1;
+        k[n] = zs > 0 ? (int)zs : (int)zs - 1;
+        const float t = (i[n] + j[n] + k[n]) * G3;
+        x0[n] = x[n] - (i[n] - t);
+        y0[n] = y[n] - (j[n] - t);
+        z0[n] = z[n] - (k[n] - t);
+    }
+
+    // Offsets of the two middle corners and gradients of all four.
+    float offset[2][3][NOISE_LANES];
+    float grad[4][3][NOISE_LANES];
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        // The corner order of raw_noise_3d(), ties broken the same way.
+        int corner[4][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {1, 1, 1}};
+        if (x0[n] >= y0[n]) {
+            corner[1][y0[n] >= z0[n] || x0[n] >= z0[n] ? 0 : 2] = 1;
+            corner[2][0] = 1;
+            corner[2][y0[n] >= z0[n] ? 1 : 2] = 1;
+        } else {
+            corner[1][y0[n] < z0[n] ? 2 : 1] = 1;
+            corner[2][1] = 1;
+            corner[2][y0[n] < z0[n] || x0[n] < z0[n] ? 2 : 0] = 1;
+        }
+        for (int m = 1; m < 3; ++m) {
+            for (int d = 0; d < 3; ++d) {
+                offset[m - 1][d][n] = (float)corner[m][d];
+            }
+        }
+
+        const int ii = i[n] & 255;
+        const int jj = j[n] & 255;
+        const int kk = k[n] & 255;
+        for (int m = 0; m < 4; ++m) {
+            const int gi = perm[ii + corner[m][0] + perm[jj + corner[m][1] +
+                                perm[kk + corner[m][2]]]] % 12;
+            for (int d = 0; d < 3; ++d) {
+                grad[m][d][n] = (float)grad3[gi][d];
+            }
+        }
+    }
+
+    // Contributions of the four corners.
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float x1 = x0[n] - offset[0][0][n] + G3;
+        const float y1 = y0[n] - offset[0][1][n] + G3;
+        const float z1 = z0[n] - offset[0][2][n] + G3;
+        const float x2 = (float)(x0[n] - offset[1][0][n] + 2.0*G3);
+        const float y2 = (float)(y0[n] - offset[1][1][n] + 2.0*G3);
+        const float z2 = (float)(z0[n] - offset[1][2][n] + 2.0*G3);
+        const float x3 = (float)(x0[n] - 1.0 + 3.0*G3);
+        const float y3 = (float)(y0[n] - 1.0 + 3.0*G3);
+        const float z3 = (float)(z0[n] - 1.0 + 3.0*G3);
+
+        float t0 = (float)(0.6 - x0[n]*x0[n] - y0[n]*y0[n] - z0[n]*z0[n]);
+        float t1 = (float)(0.6 - x1*x1 - y1*y1 - z1*z1);
+        float t2 = (float)(0.6 - x2*x2 - y2*y2 - z2*z2);
+        float t3 = (float)(0.6 - x3*x3 - y3*y3 - z3*z3);
+        const bool in0 = !(t0 < 0);
+        const bool in1 = !(t1 < 0);
+        const bool in2 = !(t2 < 0);
+        const bool in3 = !(t3 < 0);
+        t0 *= t0;
+        t1 *= t1;
+        t2 *= t2;
+        t3 *= t3;
+
+        const float dot0 = grad[0][0][n] * x0[n] + grad[0][1][n] * y0[n] + grad[0][2][n] * z0[n];
+        const float dot1 = grad[1][0][n] * x1 + grad[1][1][n] * y1 + grad[1][2][n] * z1;
+        const float dot2 = grad[2][0][n] * x2 + grad[2][1][n] * y2 + grad[2][2][n] * z2;
+        const float dot3 = grad[3][0][n] * x3 + grad[3][1][n] * y3 + grad[3][2][n] * z3;
+
+        const float n0 = in0 ? t0 * t0 * dot0 : 0.0f;
+        const float n1 = in1 ? t1 * t1 * dot1 : 0.0f;
+        const float n2 = in2 ? t2 * t2 * dot2 : 0.0f;
+        const float n3 = in3 ? t3 * t3 * dot3 : 0.0f;
+        out[n] = (float)(32.0*(n0 + n1 + n2 + n3));
+    }
+}
+
+// 4D raw Simplex noise of exactly NOISE_LANES points, see raw_noise_2d_lanes().
+NOISE_KERNEL static void raw_noise_4d_lanes(const float* x, const float* y, const float* z,
+                               const float* w, float* out)
+{
+    const float F4 = (float)((sqrtf(5.0) - 1.0) / 4.0);
+    const float G4 = (float)((5.0 - sqrtf(5.0)) / 20.0);
+
+    int i[NOISE_LANES], j[NOISE_LANES], k[NOISE_LANES], l[NOISE_LANES];
+    int c[NOISE_LANES];
+    float x0[NOISE_LANES], y0[NOISE_LANES], z0[NOISE_LANES], w0[NOISE_LANES];
+
+    // Cell and position in the cell, as in raw_noise_4d().
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float s = (x[n] + y[n] + z[n] + w[n]) * F4;
+        const float xs = x[n] + s;
+        const float ys = y[n] + s;
+        const float zs = z[n] + s;
+        const float ws = w[n] + s;
+        i[n] = xs > 0 ? (int)xs : (int)xs - 1;
+        j[n] = ys > 0 ? (int)ys : (int)ys - 1;
+        k[n] = zs > 0 ? (int)zs : (int)zs - 1;
+        l[n] = ws > 0 ? (int)ws : (int)ws - 1;
+        const float t = (i[n] + j[n] + k[n] + l[n]) * G4;
+        x0[n] = x[n] - (i[n] - t);
+        y0[n] = y[n] - (j[n] - t);
+        z0[n] = z[n] - (k[n] - t);
+        w0[n] = w[n] - (l[n] - t);
+        c[n] = ((x0[n] > y0[n]) ? 32 : 0) + ((x0[n] > z0[n]) ? 16 : 0) +
+               ((y0[n] > z0[n]) ? 8 : 0) + ((x0[n] > w0[n]) ? 4 : 0) +
+               ((y0[n] > w0[n]) ? 2 : 0) + ((z0[n] > w0[n]) ? 1 : 0);
+    }
+
+    // Offsets of the three middle corners and gradients of all five,
+    // per coordinate. Small integers, exact as floats.
+    float offset[3][4][NOISE_LANES];
+    float grad[5][4][NOISE_LANES];
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const int* order = simplex[c[n]];
+        int corner[5][4];
+        for (int d = 0; d < 4; ++d) {
+            corner[0][d] = 0;
+            corner[1][d] = order[d] >= 3 ? 1 : 0;
+            corner[2][d] = order[d] >= 2 ? 1 : 0;
+            corner[3][d] = order[d] >= 1 ? 1 : 0;
+            corner[4][d] = 1;
+        }
+        for (int m = 1; m < 4; ++m) {
+            for (int d = 0; d < 4; ++d) {
+                offset[m - 1][d][n] = (float)corner[m][d];
+            }
+        }
+
+        const int ii = i[n] & 255;
+        const int jj = j[n] & 255;
+        const int kk = k[n] & 255;
+        const int ll = l[n] & 255;
+        for (int m = 0; m < 5; ++m) {
+            const int gi = perm[ii + corner[m][0] + perm[jj + corner[m][1] +
+                                perm[kk + corner[m][2] + perm[ll + corner[m][3]]]]] % 32;
+            for (int d = 0; d < 4; ++d) {
+                grad[m][d][n] = (float)grad4[gi][d];
+            }
+        }
+    }
+
+    // Contributions of the five corners.
+    for (int n = 0; n < NOISE_LANES; ++n) {
+        const float x1 = x0[n] - offset[0][0][n] + G4;
+        const float y1 = y0[n] - offset[0][1][n] + G4;
+        const float z1 = z0[n] - offset[0][2][n] + G4;
+        const float w1 = w0[n] - offset[0][3][n] + G4;
+        const float x2 = (float)(x0[n] - offset[1][0][n] + 2.0*G4);
+        const float y2 = (float)(y0[n] - offset[1][1][n] + 2.0*G4);
+        const float z2 = (float)(z0[n] - offset[1][2][n] + 2.0*G4);
+        const float w2 = (float)(w0[n] - offset[1][3][n] + 2.0*G4);
+        const float x3 = (float)(x0[n] - offset[2][0][n] + 3.0*G4);
+        const float y3 = (float)(y0[n] - offset[2][1][n] + 3.0*G4);
+        const float z3 = (float)(z0[n] - offset[2][2][n] + 3.0*G4);
+        const float w3 = (float)(w0[n] - offset[2][3][n] + 3.0*G4);
+        const float x4 = (float)(x0[n] - 1.0 + 4.0*G4);
+        const float y4 = (float)(y0[n] - 1.0 + 4.0*G4);
+        const float z4 = (float)(z0[n] - 1.0 + 4.0*G4);
+        const float w4 = (float)(w0[n] - 1.0 + 4.0*G4);
+
+        float t0 = (float)(0.6 - x0[n]*x0[n] - y0[n]*y0[n] - z0[n]*z0[n] - w0[n]*w0[n]);
+        float t1 = (float)(0.6 - x1*x1 - y1*y1 - z1*z1 - w1*w1);
+        float t2 = (float)(0.6 - x2*x2 - y2*y2 - z2*z2 - w2*w2);
+        float t3 = (float)(0.6 - x3*x3 - y3*y3 - z3*z3 - w3*w3);
+        float t4 = (float)(0.6 - x4*x4 - y4*y4 - z4*z4 - w4*w4);
+        const bool in0 = !(t0 < 0);
+        const bool in1 = !(t1 < 0);
+        const bool in2 = !(t2 < 0);
+        const bool in3 = !(t3 < 0);
+        const bool in4 = !(t4 < 0);
+        t0 *= t0;
+        t1 *= t1;
+        t2 *= t2;
+        t3 *= t3;
+        t4 *= t4;
+
+        const float dot0 = grad[0][0][n] * x0[n] + grad[0][1][n] * y0[n] +
+                           grad[0][2][n] * z0[n] + grad[0][3][n] * w0[n];
+        const float dot1 = grad[1][0][n] * x1 + grad[1][1][n] * y1 +
+                           grad[1][2][n] * z1 + grad[1][3][n] * w1;
+        const float dot2 = grad[2][0][n] * x2 + grad[2][1][n] * y2 +
+                           grad[2][2][n] * z2 + grad[2][3][n] * w2;
+        const float dot3 = grad[3][0][n] * x3 + grad[3][1][n] * y3 +
+                           grad[3][2][n] * z3 + grad[3][3][n] * w3;
+        const float dot4 = grad[4][0][n] * x4 + grad[4][1][n] * y4 +
+                           grad[4][2][n] * z4 + grad[4][3][n] * w4;
+
+        const float n0 = in0 ? t0 * t0 * dot0 : 0.0f;
+        const float n1 = in1 ? t1 * t1 * dot1 : 0.0f;
+        const float n2 = in2 ? t2 * t2 * dot2 : 0.0f;
+        const float n3 = in3 ? t3 * t3 * dot3 : 0.0f;
+        const float n4 = in4 ? t4 * t4 * dot4 : 0.0f;
+        out[n] = (float)(27.0 * (n0 + n1 + n2 + n3 + n4));
+    }
+}
+
+void raw_noise_2d(const float* x, const float* y, float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        raw_noise_2d_lanes(x + n, y + n, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = raw_noise_2d(x[n], y[n]);
+    }
+}
+
+void raw_noise_3d(const float* x, const float* y, const float* z, float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        raw_noise_3d_lanes(x + n, y + n, z + n, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = raw_noise_3d(x[n], y[n], z[n]);
+    }
+}
+
+void raw_noise_4d(const float* x, const float* y, const float* z, const float* w,
+                  float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        raw_noise_4d_lanes(x + n, y + n, z + n, w + n, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = raw_noise_4d(x[n], y[n], z[n], w[n]);
+    }
+}
+
+// Multi-octave noise of NOISE_LANES points of up to four coordinates,
+// accumulated as octave_noise_4d() does and scaled as
+// scaled_octave_noise_4d() does.
+static void scaled_octave_noise_lanes(const float octaves, const float persistence,
+                                      const float scale, const float loBound,
+                                      const float hiBound, const int dimensions,
+                                      const float* const* coords, float* out) {
+    float f[4][NOISE_LANES];
+    float noise[NOISE_LANES];
+    float total[NOISE_LANES] = {};
+    float frequency = scale;
+    float amplitude = 1;
+    float maxAmplitude = 0;
+
+    for (int i = 0; i < octaves; i++) {
+        for (int d = 0; d < dimensions; ++d) {
+            for (int m = 0; m < NOISE_LANES; ++m) {
+                f[d][m] = coords[d][m] * frequency;
+            }
+        }
+        switch (dimensions) {
+        case 2:
+            raw_noise_2d_lanes(f[0], f[1], noise);
+            break;
+        case 3:
+            raw_noise_3d_lanes(f[0], f[1], f[2], noise);
+            break;
+        default:
+            raw_noise_4d_lanes(f[0], f[1], f[2], f[3], noise);
+            break;
+        }
+        for (int m = 0; m < NOISE_LANES; ++m) {
+            total[m] += noise[m] * amplitude;
+        }
+
+        frequency *= 2;
+        maxAmplitude += amplitude;
+        amplitude *= persistence;
+    }
+
+    for (int m = 0; m < NOISE_LANES; ++m) {
+        out[m] = total[m] / maxAmplitude * (hiBound - loBound) / 2 + (hiBound + loBound) / 2;
+    }
+}
+
+void scaled_octave_noise_2d(const float octaves, const float persistence, const float scale,
+                            const float loBound, const float hiBound,
+                            const float* x, const float* y, float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        const float* coords[2] = {x + n, y + n};
+        scaled_octave_noise_lanes(octaves, persistence, scale, loBound, hiBound,
+                                  2, coords, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = scaled_octave_noise_2d(octaves, persistence, scale, loBound, hiBound,
+                                        x[n], y[n]);
+    }
+}
+
+void scaled_octave_noise_3d(const float octaves, const float persistence, const float scale,
+                            const float loBound, const float hiBound,
+                            const float* x, const float* y, const float* z,
+                            float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        const float* coords[3] = {x + n, y + n, z + n};
+        scaled_octave_noise_lanes(octaves, persistence, scale, loBound, hiBound,
+                                  3, coords, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = scaled_octave_noise_3d(octaves, persistence, scale, loBound, hiBound,
+                                        x[n], y[n], z[n]);
+    }
+}
+
+void scaled_octave_noise_4d(const float octaves, const float persistence, const float scale,
+                            const float loBound, const float hiBound,
+                            const float* x, const float* y, const float* z, const float* w,
+                            float* out, uint32_t count) {
+    uint32_t n = 0;
+    for (; n + NOISE_LANES <= count; n += NOISE_LANES) {
+        const float* coords[4] = {x + n, y + n, z + n, w + n};
+        scaled_octave_noise_lanes(octaves, persistence, scale, loBound, hiBound,
+                                  4, coords, out + n);
+    }
+    for (; n < count; ++n) {
+        out[n] = scaled_octave_noise_4d(octaves, persistence, scale, loBound, hiBound,
+                                        x[n], y[n], z[n], w[n]);
+    }
+}
+
 int fastfloor(const float x) {
     return x > 0 ? (int)x : (int)x - 1;
 }
@@ -545,27 +978,23 @@ int simplexnoise(int32_t seed, float* map, int width, int height, float persiste
     float kb = (float)(seed * 567 % 256);
     float kc = (float)((seed*seed) % 256);
     float kd = (float)((567 - seed) % 256);
+
+    // The circle coordinates only depend on the column or on the row.
+    std::vector<float> xs(width), ys(width), zs(width), ws(width);
+    for (int x = 0; x < width; x++) {
+        float fNX = x * inv_width; // we let the x-offset define the circle
+        float fRdx = (float)(fNX * 2 * PI); // a full circle is two pi radians
+        xs[x] = ka + sinf(fRdx)*noiseScale;
+        ys[x] = kb + cosf(fRdx)*noiseScale;
+    }
     for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float fNX = x * inv_width; // we let the x-offset define the circle
-            float fNY = y * inv_height; // we let the x-offset define the circle
-            float fRdx = (float)(fNX * 2 * PI); // a full circle is two pi radians
-            float fRdy = (float)(fNY * 4 * PI); // a full circle is two pi radians
-            float a = sinf(fRdx);
-            float b = cosf(fRdx);
-            float c = sinf(fRdy);
-            float d = cosf(fRdy);
-            float v = scaled_octave_noise_4d(16.0f,
-                                             persistence,
-                                             0.5f,
-                                             0.0f,
-                                             1.0f,
-                                             ka + a*noiseScale,
-                                             kb + b*noiseScale,
-                                             kc + c*noiseScale,
-                                             kd + d*noiseScale);
-            map[y * width + x] = v;
-        }
+        float fNY = y * inv_height; // we let the x-offset define the circle
+        float fRdy = (float)(fNY * 4 * PI); // a full circle is two pi radians
+        std::fill(zs.begin(), zs.end(), kc + sinf(fRdy)*noiseScale);
+        std::fill(ws.begin(), ws.end(), kd + cosf(fRdy)*noiseScale);
+        scaled_octave_noise_4d(16.0f, persistence, 0.5f, 0.0f, 1.0f,
+                               xs.data(), ys.data(), zs.data(), ws.data(),
+                               map + y * width, width);
     }
 
     return 0;
@@ -129,6 +129,46 @@ float raw_noise_3d(const float x, const float y, const float z);
 float raw_noise_4d(const float x, const float y, const float, const float w);
 
 
+// Batch Simplex noise - count values, each the same bit for bit as the
+// single value function gives for x[i], y[i], z[i], w[i]. Several points
+// are computed at once with the SIMD instructions the CPU has.
+void raw_noise_2d(const float* x, const float* y, float* out, uint32_t count);
+void raw_noise_3d(const float* x, const float* y, const float* z,
+                  float* out, uint32_t count);
+void raw_noise_4d(const float* x, const float* y, const float* z, const float* w,
+                  float* out, uint32_t count);
+void scaled_octave_noise_2d(const float octaves,
+                            const float persistence,
+                            const float scale,
+                            const float loBound,
+                            const float hiBound,
+                            const float* x,
+                            const float* y,
+                            float* out,
+                            uint32_t count);
+void scaled_octave_noise_3d(const float octaves,
+                            const float persistence,
+                            const float scale,
+                            const float loBound,
+                            const float hiBound,
+                            const float* x,
+                            const float* y,
+                            const float* z,
+                            float* out,
+                            uint32_t count);
+void scaled_octave_noise_4d(const float octaves,
+                            const float persistence,
+                            const float scale,
+                            const float loBound,
+                            const float hiBound,
+                            const float* x,
+                            const float* y,
+                            const float* z,
+                            const float* w,
+                            float* out,
+                            uint32_t count);
+
+
 int fastfloor(const float x);
 
 float dot(const int* g, const float x, const float y);
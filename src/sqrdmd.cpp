@@ -25,6 +25,8 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
+#include <algorithm>
+#include <functional>
 #include <stdexcept>
 #ifdef __MINGW32__ // this is to avoid a problem with the hypot function which is messed up by Python...
 #undef __STRICT_ANSI__
@@ -226,3 +228,92 @@ int sqrdmd(long seed, float* map, int size, float rgh)
     }
     return (0);
 }
+
+// Random offset in [-0.5, 0.5] of the point (x, y) at the given level of
+// sqrdmd_hashed(): the SplitMix64 finalizer of all four values.
+static float hashed_offset(uint64_t seed, uint32_t level, uint32_t x, uint32_t y)
+{
+    uint64_t h = seed ^ ((uint64_t)level << 56) ^ ((uint64_t)y << 28) ^ x;
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return (float)((double)(uint32_t)(h >> 32) / 4294967295.0) - 0.5f;
+}
+
+int sqrdmd_hashed(long seed, float* map, int size, float rgh, ThreadPool* pool)
+{
+    const int temp = size - 1;
+    // MUST EQUAL TO 2^x + 1!
+    ASSERT(!(temp & (temp - 1) || temp & 3), "Side should be 2**n +1");
+    const int last = size - 1;
+    float slope = rgh;
+    uint32_t level = 0;
+
+    // Call row(r) for r in [0, rows), in bands on the pool's threads.
+    const auto forRows = [pool](int rows, const std::function<void(int)>& row) {
+        const uint32_t num_bands = pool ? std::min(pool->size(), (uint32_t)rows) : 1;
+        const auto band = [&](uint32_t b) {
+            const int first = (int)(b * rows / num_bands);
+            const int end = (int)((b + 1) * rows / num_bands);
+            for (int r = first; r < end; ++r) {
+                row(r);
+            }
+        };
+        if (num_bands > 1) {
+            pool->parallelFor(num_bands, band);
+        } else {
+            band(0);
+        }
+    };
+
+    // Points that are not zero are left as they are, as in sqrdmd().
+    const auto save = [map](int i, float sum) {
+        if ((int)map[i] == 0) {
+            map[i] = sum;
+        }
+    };
+
+    for (int step = last; step > 1; step >>= 1, slope *= rgh, ++level) {
+        const int half = step >> 1;
+
+        /* Midpoints of the squares ("diamond step"): their corners are
+         * points of the previous levels. */
+        forRows(last / step, [&](int r) {
+            const int y = r * step + half;
+            for (int x = half; x < last; x += step) {
+                const float sum = (map[(y - half) * size + x - half] +
+                                   map[(y - half) * size + x + half] +
+                                   map[(y + half) * size + x - half] +
+                                   map[(y + half) * size + x + half]) * 0.25f;
+                save(y * size + x, sum + slope * hashed_offset(seed, level, x, y));
+            }
+        });
+
+        /* Centers of the diamonds ("square step"): two vertices are corners
+         * of the squares, two the midpoints just calculated. Vertices beyond
+         * the top or left edge wrap around to the other side. */
+        forRows(last / half, [&](int r) {
+            const int y = r * half;
+            const int up = y == 0 ? last - half : y - half;
+            for (int x = (r & 1) ? 0 : half; x < last; x += step) {
+                const int left = x == 0 ? last - half : x - half;
+                const float sum = (map[y * size + x + half] +
+                                   map[(y + half) * size + x] +
+                                   map[y * size + left] +
+                                   map[up * size + x]) * 0.25f;
+                save(y * size + x, sum + slope * hashed_offset(seed, level, x, y));
+            }
+        });
+
+        /* Copy the top row into the bottom one and the left column into the
+         * right one. */
+        for (int x = half; x < last; x += step) {
+            map[last * size + x] = map[x];
+        }
+        for (int y = half; y < last; y += step) {
+            map[y * size + last] = map[y * size];
+        }
+    }
+    return (0);
+}
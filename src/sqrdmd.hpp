@@ -25,6 +25,8 @@
 #ifndef SQRDMD_H
 #define SQRDMD_H
 
+#include "thread_pool.hpp"
+
 /**
  * @brief Scales the values of the map between [0, 1[.
  *
@@ -49,4 +51,25 @@ void normalize(float* map, int size);
  */
 int sqrdmd(long seed, float* map, const int size, float rgh);
 
+/**
+ *  @brief Generates a two dimensional fractal height map in parallel.
+ *
+ *  Same algorithm and parameters as sqrdmd(), but the random offset of each
+ *  point is a hash of the seed, the level of the subdivision and the point's
+ *  coordinates instead of the next number of one random sequence. The points
+ *  of each diamond and square step are then independent, and their rows are
+ *  shared by the threads of the pool. The map is the same for any number of
+ *  threads; without a pool it is computed on the calling thread only.
+ *
+ *  The result differs from the one of sqrdmd() with the same seed.
+ *
+ *  @param	map Destination array to store the results.
+ *  @param	size Length of map's side: 2^x + 1, x = 1, 2, 3 ...
+ *  @param	rgh Amount of roughness/randomness in the final map.
+ *  @param	pool Threads to use, or nullptr.
+ *  @return	Returns zero on success.
+ */
+int sqrdmd_hashed(long seed, float* map, const int size, float rgh,
+                  ThreadPool* pool = nullptr);
+
 #endif
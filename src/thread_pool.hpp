@@ -0,0 +1,78 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils.hpp"
+
+/// Fixed set of worker threads sharing the iterations of a loop.
+///
+/// The thread calling parallelFor() takes part in the work, so a pool of
+/// N threads starts N - 1 workers. A pool of one thread runs everything
+/// inline on the caller and never synchronizes.
+class ThreadPool
+{
+public:
+    /// @param num_threads Threads working on each loop, caller included.
+    ///                    Zero means one thread per hardware core.
+    explicit ThreadPool(uint32_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads working on each loop, caller included.
+    uint32_t size() const
+    {
+        return static_cast<uint32_t>(_workers.size()) + 1;
+    }
+
+    /// Call task(i) once for each i in [0, count) and wait for all of them.
+    ///
+    /// Calls are spread over the threads in no particular order, so the
+    /// task must not depend on the order of iterations. If a call throws,
+    /// the first exception is rethrown here once every call has finished.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;   ///< Signals workers: new loop or stop.
+    std::condition_variable _done;   ///< Signals caller: all workers idle.
+    const std::function<void(uint32_t)>* _task;
+    uint32_t _count;                 ///< Iterations of the current loop.
+    std::atomic<uint32_t> _next;     ///< Next iteration to hand out.
+    uint32_t _busy;                  ///< Workers still in the current loop.
+    uint64_t _generation;            ///< Incremented for every loop.
+    bool _stopping;
+    std::exception_ptr _error;
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "utils.hpp"
 #include <sstream>
+#include <vector>
 
 namespace Platec {
 
@@ -35,3 +36,48 @@ std::string to_string_f(float value) {
 }
 
 }
+
+float find_value_for_quantile(const float quantile, const float* array, const uint32_t size,
+                              const float precision)
+{
+    // Every value tested by the bisection is a multiple of the last step it
+    // tests with. Counting the array once in bins that wide gives the
+    // number of values below any of them.
+    uint32_t num_bins = 1;
+    for (float th_step = 0.5f; th_step > precision; th_step *= 0.5f) {
+        num_bins <<= 1;
+    }
+    ASSERT(num_bins <= (1u << 24), "Precision too fine for the quantile search");
+    const float scale = static_cast<float>(num_bins);
+
+    // below[k] is first the number of values in [k, k + 1[ / num_bins, then
+    // the number of values below k / num_bins. Values below 0 go into the
+    // first bin, values of 1 or more (and NaN) into the last. Scaling by a
+    // power of two is exact, so each value lands in the bin the comparisons
+    // of a plain bisection would put it in.
+    std::vector<uint32_t> below(num_bins + 1, 0);
+    for (uint32_t i = 0; i < size; ++i) {
+        const float v = array[i] * scale;
+        ++below[v < 0 ? 0 : v < scale ? static_cast<uint32_t>(v) : num_bins];
+    }
+    uint32_t sum = 0;
+    for (uint32_t k = 0; k <= num_bins; ++k) {
+        const uint32_t in_bin = below[k];
+        below[k] = sum;
+        sum += in_bin;
+    }
+
+    float value = 0.5f;
+    float th_step = 0.5f;
+    while (th_step > precision)
+    {
+        const uint32_t count = below[static_cast<uint32_t>(value * scale)];
+
+        th_step *= 0.5f;
+        if (count / (float)size < quantile)
+            value += th_step;
+        else
+            value -= th_step;
+    }
+    return value;
+}
@@ -44,6 +44,13 @@ std::string to_string_f(float value);
 
 }
 
+/// Value in [0, 1[ below which the given fraction of the array lies, found
+/// by bisection: starting from 0.5 and halving the step while it is larger
+/// than precision. The array is only read once, however many steps are
+/// taken; its values may be outside of [0, 1].
+float find_value_for_quantile(const float quantile, const float* array, const uint32_t size,
+                              const float precision);
+
 // MK: I strongly feel that a release build should have this disabled,
 // but I'm keeping it here because that is the wishes of FT
 #define LOG_ASSERTS // Remove this to remove printing asserts in release mode
@@ -85,6 +85,142 @@ TEST(HeightMap, SetAll)
     ASSERT_TRUE(1.789f == hm.get(49, 19));
 }
 
+TEST(HeightMap, SetAllWithUniformBytes)
+{
+    IndexMap im = IndexMap(50, 20);
+    im.set_all(0xFFFFFFFF);
+    ASSERT_EQ(0xFFFFFFFF, im.get( 0,  0));
+    ASSERT_EQ(0xFFFFFFFF, im.get(49, 19));
+    im.set_all(0x01020304);
+    ASSERT_EQ(0x01020304u, im.get( 0,  0));
+    ASSERT_EQ(0x01020304u, im.get(49, 19));
+    im.set_all(0);
+    ASSERT_EQ(0u, im.get( 0,  0));
+    ASSERT_EQ(0u, im.get(49, 19));
+}
+
+TEST(HeightMap, AssignmentOperatorResizes)
+{
+    HeightMap hm = HeightMap(50, 20);
+    hm.set(49, 19, 0.9f);
+    HeightMap hm2 = HeightMap(10, 10);
+    hm2 = hm;
+    ASSERT_EQ(50, hm2.width());
+    ASSERT_EQ(20, hm2.height());
+    ASSERT_TRUE(0.9f == hm2.get(49, 19));
+    ASSERT_TRUE(hm.raw_data() != hm2.raw_data());
+}
+
+TEST(HeightMap, MoveConstructor)
+{
+    HeightMap hm = HeightMap(50, 20);
+    hm.set(20, 18, 0.7f);
+    const float* data = hm.raw_data();
+    HeightMap hm2(std::move(hm));
+    ASSERT_EQ(data, hm2.raw_data());
+    ASSERT_EQ(1000, hm2.area());
+    ASSERT_TRUE(0.7f == hm2.get(20, 18));
+    ASSERT_EQ(0, hm.area());
+}
+
+TEST(HeightMap, MoveAssignment)
+{
+    HeightMap hm = HeightMap(50, 20);
+    hm.set(20, 18, 0.7f);
+    const float* data = hm.raw_data();
+    HeightMap hm2 = HeightMap(10, 10);
+    hm2 = std::move(hm);
+    ASSERT_EQ(data, hm2.raw_data());
+    ASSERT_EQ(50, hm2.width());
+    ASSERT_EQ(20, hm2.height());
+    ASSERT_TRUE(0.7f == hm2.get(20, 18));
+}
+
+TEST(HeightMap, GrowMovesContent)
+{
+    HeightMap hm = HeightMap(3, 2);
+    for (uint32_t i = 0; i < hm.area(); ++i) {
+        hm[i] = 1.0f + i;
+    }
+    hm.grow(6, 4, 2, 1, 0.0f);
+    ASSERT_EQ(6, hm.width());
+    ASSERT_EQ(4, hm.height());
+    ASSERT_EQ(24, hm.area());
+    for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 6; ++x) {
+            const bool old = x >= 2 && x < 5 && y >= 1 && y < 3;
+            const float expected = old ? 1.0f + (y - 1) * 3 + (x - 2) : 0.0f;
+            ASSERT_TRUE(expected == hm.get(x, y)) << x << "," << y;
+        }
+    }
+}
+
+TEST(HeightMap, GrowReusesStorage)
+{
+    IndexMap im = IndexMap(4, 4);
+    im.set_all(7);
+    im.grow(4, 6, 0, 0, 1);
+    const uint32_t* data = im.raw_data();
+
+    // The first growth left headroom for the next small ones.
+    im.grow(4, 7, 0, 1, 2);
+    im.grow(5, 7, 1, 0, 3);
+    ASSERT_EQ(data, im.raw_data());
+    ASSERT_EQ(3u, im.get(0, 0));
+    ASSERT_EQ(2u, im.get(1, 0));
+    ASSERT_EQ(7u, im.get(1, 1));
+    ASSERT_EQ(7u, im.get(4, 4));
+    ASSERT_EQ(1u, im.get(4, 5));
+    ASSERT_EQ(1u, im.get(4, 6));
+}
+
+TEST(PaddedMatrix, HaloHoldsBorder)
+{
+    HeightMap hm = HeightMap(5, 3);
+    for (uint32_t i = 0; i < hm.area(); ++i) {
+        hm[i] = static_cast<float>(i);
+    }
+    PaddedMatrix<float> padded;
+    padded.assign(hm, false, false, -1.0f);
+    ASSERT_EQ(5u, padded.width());
+    ASSERT_EQ(3u, padded.height());
+    for (int y = 0; y < 3; ++y) {
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(padded.row(y)) % 64);
+        ASSERT_TRUE(-1.0f == padded.row(y)[-1]);
+        ASSERT_TRUE(-1.0f == padded.row(y)[5]);
+        for (int x = 0; x < 5; ++x) {
+            ASSERT_TRUE(hm.get(x, y) == padded.row(y)[x]);
+        }
+    }
+    for (int x = -1; x <= 5; ++x) {
+        ASSERT_TRUE(-1.0f == padded.row(-1)[x]);
+        ASSERT_TRUE(-1.0f == padded.row(3)[x]);
+    }
+}
+
+TEST(PaddedMatrix, HaloWrapsAround)
+{
+    HeightMap hm = HeightMap(5, 3);
+    for (uint32_t i = 0; i < hm.area(); ++i) {
+        hm[i] = static_cast<float>(i);
+    }
+    PaddedMatrix<float> padded;
+    padded.assign(hm, true, true, -1.0f);
+    for (int y = 0; y < 3; ++y) {
+        ASSERT_TRUE(hm.get(4, y) == padded.row(y)[-1]);
+        ASSERT_TRUE(hm.get(0, y) == padded.row(y)[5]);
+    }
+    for (int x = 0; x < 5; ++x) {
+        ASSERT_TRUE(hm.get(x, 2) == padded.row(-1)[x]);
+        ASSERT_TRUE(hm.get(x, 0) == padded.row(3)[x]);
+    }
+
+    // Only one axis wraps.
+    padded.assign(hm, true, false, -1.0f);
+    ASSERT_TRUE(hm.get(4, 1) == padded.row(1)[-1]);
+    ASSERT_TRUE(-1.0f == padded.row(-1)[2]);
+}
+
 TEST(HeightMap, IndexedAccessOperatorFromIndex)
 {
     HeightMap hm = HeightMap(50, 20);
@@ -0,0 +1,347 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include "platecapi.hpp"
+#include "lithosphere.hpp"
+#include "plate.hpp"
+#include "plate_collisions.hpp"
+#include "segment_creator.hpp"
+#include "segments.hpp"
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+
+TEST(PhaseStats, Names)
+{
+    ASSERT_EQ(PHASE_COUNT, platec_api_get_phase_count());
+    for (uint32_t i = 0; i < platec_api_get_phase_count(); ++i) {
+        EXPECT_TRUE(platec_api_get_phase_name(i) != nullptr);
+    }
+    EXPECT_TRUE(platec_api_get_phase_name(PHASE_COUNT) == nullptr);
+}
+
+TEST(PhaseStats, CountsEveryUpdate)
+{
+    void* p = platec_api_create(3, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    for (int i = 0; i < 5; ++i) {
+        platec_api_step(p);
+    }
+
+    uint64_t calls[PHASE_COUNT] = {};
+    double seconds[PHASE_COUNT] = {};
+    uint32_t written = platec_api_get_phase_stats(p, calls, seconds);
+
+#ifdef PLATEC_PHASE_STATS
+    ASSERT_EQ(PHASE_COUNT, written);
+    for (uint32_t i = 0; i < PHASE_COUNT; ++i) {
+        EXPECT_EQ(5u, calls[i]) << platec_api_get_phase_name(i);
+        EXPECT_GE(seconds[i], 0.0);
+    }
+
+    platec_api_reset_phase_stats(p);
+    platec_api_get_phase_stats(p, calls, seconds);
+    EXPECT_EQ(0u, calls[PHASE_MOVE_AND_ERODE]);
+#else
+    EXPECT_EQ(0u, written);
+#endif
+
+    platec_api_destroy(p);
+}
+
+// Topography and plate ownership of a world after some steps.
+static void runWorld(long seed, int steps, std::vector<float>* heights,
+                     std::vector<uint32_t>* owners)
+{
+    lithosphere litho(seed, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    for (int i = 0; i < steps && !litho.isFinished(); ++i) {
+        litho.update();
+    }
+
+    const uint32_t area = litho.getWidth() * litho.getHeight();
+    heights->assign(litho.getTopography(), litho.getTopography() + area);
+    owners->assign(litho.getPlatesMap(), litho.getPlatesMap() + area);
+}
+
+TEST(Lithosphere, ConcurrentWorldsMatchSerialRuns)
+{
+    // Enough steps to go through an erosion (at iteration 60) and so
+    // through flowRivers and segment creation.
+    const int steps = 40;
+    const int num_worlds = 4;
+
+    std::vector<float> serial_heights[num_worlds];
+    std::vector<uint32_t> serial_owners[num_worlds];
+    for (int i = 0; i < num_worlds; ++i) {
+        runWorld(100 + i, steps, &serial_heights[i], &serial_owners[i]);
+    }
+
+    std::vector<float> heights[num_worlds];
+    std::vector<uint32_t> owners[num_worlds];
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_worlds; ++i) {
+        workers.emplace_back(runWorld, 100 + i, steps, &heights[i], &owners[i]);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (int i = 0; i < num_worlds; ++i) {
+        EXPECT_TRUE(serial_heights[i] == heights[i]) << "world " << i;
+        EXPECT_TRUE(serial_owners[i] == owners[i]) << "world " << i;
+    }
+}
+
+TEST(Lithosphere, ThreadCountDoesNotChangeResult)
+{
+    lithosphere serial(7, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 1);
+    lithosphere threaded(7, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 4);
+
+    const uint32_t area = serial.getWidth() * serial.getHeight();
+    for (int step = 0; step < 40; ++step) {
+        serial.update();
+        threaded.update();
+        ASSERT_EQ(0, memcmp(serial.getTopography(), threaded.getTopography(),
+                            area * sizeof(float))) << "step " << step;
+        ASSERT_EQ(0, memcmp(serial.getPlatesMap(), threaded.getPlatesMap(),
+                            area * sizeof(uint32_t))) << "step " << step;
+    }
+}
+
+TEST(Lithosphere, UnevenBandsDoNotChangeResult)
+{
+    // 3 threads cut the 200 rows of the map in bands of unequal height.
+    lithosphere serial(42, 300, 200, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 1);
+    lithosphere threaded(42, 300, 200, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 3);
+
+    const uint32_t area = serial.getWidth() * serial.getHeight();
+    for (int step = 0; step < 40; ++step) {
+        serial.update();
+        threaded.update();
+        ASSERT_EQ(0, memcmp(serial.getTopography(), threaded.getTopography(),
+                            area * sizeof(float))) << "step " << step;
+        ASSERT_EQ(0, memcmp(serial.getPlatesMap(), threaded.getPlatesMap(),
+                            area * sizeof(uint32_t))) << "step " << step;
+        ASSERT_EQ(0, memcmp(serial.getAgeMap(), threaded.getAgeMap(),
+                            area * sizeof(uint32_t))) << "step " << step;
+    }
+}
+
+TEST(Lithosphere, RemovingPlatesKeepsIndexMapValid)
+{
+    lithosphere litho(3, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    const uint32_t area = litho.getWidth() * litho.getHeight();
+    const uint32_t initial_plates = litho.getPlateCount();
+
+    // Plates die around step 100 and 160 with this seed.
+    for (int step = 0; step < 200; ++step) {
+        litho.update();
+        const uint32_t* owners = litho.getPlatesMap();
+        for (uint32_t i = 0; i < area; ++i) {
+            ASSERT_LT(owners[i], litho.getPlateCount()) << "step " << step;
+        }
+    }
+    EXPECT_LT(litho.getPlateCount(), initial_plates);
+}
+
+TEST(Lithosphere, RiverRoutingIsSelectable)
+{
+    lithosphere frontier(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere flood(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere threaded(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 3);
+    EXPECT_EQ(RIVERS_FRONTIER, frontier.getRiverRouting());
+    flood.setRiverRouting(RIVERS_PRIORITY_FLOOD);
+    EXPECT_EQ(RIVERS_PRIORITY_FLOOD, flood.getRiverRouting());
+    threaded.setRiverRouting(RIVERS_PRIORITY_FLOOD);
+
+    // Through the erosion at iteration 60.
+    for (int step = 0; step < 62; ++step) {
+        frontier.update();
+        flood.update();
+        threaded.update();
+    }
+
+    const uint32_t area = flood.getWidth() * flood.getHeight();
+    EXPECT_NE(0, memcmp(frontier.getTopography(), flood.getTopography(),
+                        area * sizeof(float)));
+    EXPECT_EQ(0, memcmp(flood.getTopography(), threaded.getTopography(),
+                        area * sizeof(float)));
+}
+
+TEST(Lithosphere, ErosionOptionsOfCreate)
+{
+    EXPECT_TRUE(platec_api_create(3, 64, 64, 0.65f, 60, 0.02f, 1000000, 0.33f,
+                                  2, 10, 1, EROSION_STRATEGY_COUNT, 0) == nullptr);
+    EXPECT_TRUE(platec_api_create(3, 64, 64, 0.65f, 60, 0.02f, 1000000, 0.33f,
+                                  2, 10, 1, 0, EROSION_SCHEDULE_COUNT) == nullptr);
+
+    void* p = platec_api_create(3, 64, 64, 0.65f, 60, 0.02f, 1000000, 0.33f,
+                                2, 10, 1, EROSION_THERMAL, EROSION_AT_END);
+    ASSERT_TRUE(p != nullptr);
+    const lithosphere* litho = static_cast<lithosphere*>(p);
+    EXPECT_TRUE(dynamic_cast<const ThermalErosion*>(&litho->getErosion()) != nullptr);
+    EXPECT_EQ(EROSION_AT_END, litho->getErosionSchedule());
+    platec_api_destroy(p);
+}
+
+TEST(Lithosphere, ErosionAtEndSkipsPeriodicErosion)
+{
+    // Within a cycle, eroding at its end is the same as not eroding.
+    lithosphere never(9, 128, 128, 0.65f, 0, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere at_end(9, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    at_end.setErosionSchedule(EROSION_AT_END);
+
+    const uint32_t area = never.getWidth() * never.getHeight();
+    for (int step = 0; step < 62; ++step) {
+        never.update();
+        at_end.update();
+    }
+    ASSERT_EQ(0u, never.getCycleCount());
+    EXPECT_EQ(0, memcmp(never.getTopography(), at_end.getTopography(),
+                        area * sizeof(float)));
+}
+
+TEST(Lithosphere, ThermalErosionIsSelectable)
+{
+    lithosphere rivers(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere thermal(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    thermal.setErosion(new ThermalErosion());
+
+    for (int step = 0; step < 62; ++step) {
+        rivers.update();
+        thermal.update();
+    }
+
+    const uint32_t area = rivers.getWidth() * rivers.getHeight();
+    EXPECT_NE(0, memcmp(rivers.getTopography(), thermal.getTopography(),
+                        area * sizeof(float)));
+    EXPECT_THROW(thermal.setErosion(nullptr), invalid_argument);
+}
+
+TEST(Lithosphere, UnionFindSegmentationIsSelectable)
+{
+    lithosphere eager(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere threaded(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 3);
+    EXPECT_EQ(SEGMENTS_LAZY_FLOOD, eager.getSegmentation());
+    eager.setSegmentation(SEGMENTS_UNION_FIND);
+    threaded.setSegmentation(SEGMENTS_UNION_FIND);
+
+    for (int step = 0; step < 100; ++step) {
+        eager.update();
+        threaded.update();
+    }
+
+    const uint32_t area = eager.getWidth() * eager.getHeight();
+    EXPECT_EQ(0, memcmp(eager.getTopography(), threaded.getTopography(),
+                        area * sizeof(float)));
+
+    // Right after the plates are eroded and moved, the labels are those a
+    // flood fill finds on each plate's current map.
+    eager.movePlates(true);
+    const WorldDimension& world = eager.getWorldDimension();
+    for (uint32_t p = 0; p < eager.getPlateCount(); ++p) {
+        const plate& pl = *eager.getPlate(p);
+        const uint32_t w = pl.getWidth(), h = pl.getHeight();
+        const float* crust;
+        const uint32_t* age;
+        pl.getMap(&crust, &age);
+        HeightMap map(w, h);
+        memcpy(map.raw_data(), crust, w * h * sizeof(float));
+        Bounds bounds(world, FloatPoint(pl.getLeftAsUint(), pl.getTopAsUint()),
+                      Dimension(w, h));
+        Segments segments(w * h);
+        MySegmentCreator creator(bounds, &segments, map, world);
+        segments.setSegmentCreator(&creator);
+        segments.setBounds(&bounds);
+        for (uint32_t y = 0, i = 0; y < h; ++y) {
+            for (uint32_t x = 0; x < w; ++x, ++i) {
+                if (map[i] < CONT_BASE) {
+                    continue;
+                }
+                const uint32_t wx = (pl.getLeftAsUint() + x) % world.getWidth();
+                const uint32_t wy = (pl.getTopAsUint() + y) % world.getHeight();
+                const ContinentId id = segments.getContinentAt(wx, wy);
+                ASSERT_EQ(segments[id].area(), pl.getContinentArea(wx, wy))
+                    << "plate " << p << " point " << i;
+            }
+        }
+    }
+    EXPECT_EQ(0u, platec_api_set_segmentation(&eager, SEGMENTATION_COUNT));
+    EXPECT_EQ(SEGMENTS_UNION_FIND, eager.getSegmentation());
+}
+
+TEST(Lithosphere, PerContinentCollisionsAreSelectable)
+{
+    lithosphere per_point(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere per_continent(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10);
+    lithosphere threaded(5, 128, 128, 0.65f, 60, 0.02f, 1000000, 0.33f, 2, 10, 3);
+    EXPECT_EQ(COLLISIONS_PER_POINT, per_point.getCollisionResolution());
+    per_continent.setCollisionResolution(COLLISIONS_PER_CONTINENT);
+    threaded.setCollisionResolution(COLLISIONS_PER_CONTINENT);
+
+    for (int step = 0; step < 100; ++step) {
+        per_point.update();
+        per_continent.update();
+        threaded.update();
+    }
+
+    const uint32_t area = per_continent.getWidth() * per_continent.getHeight();
+    EXPECT_NE(0, memcmp(per_point.getTopography(), per_continent.getTopography(),
+                        area * sizeof(float)));
+    EXPECT_EQ(0, memcmp(per_continent.getTopography(), threaded.getTopography(),
+                        area * sizeof(float)));
+    EXPECT_EQ(0u, platec_api_set_collision_resolution(&per_continent,
+                                                      COLLISION_RESOLUTION_COUNT));
+    EXPECT_EQ(COLLISIONS_PER_CONTINENT, per_continent.getCollisionResolution());
+}
+
+TEST(PlateCollisions, SumByContinentsAddsUpEachPair)
+{
+    // Plate 0 gets six records, so its hash table has 16 slots. Find a
+    // continent whose pair lands in the same slot as continent 0.
+    const uint32_t mask = 15;
+    ContinentId clash = 1;
+    while ((plateCollisions::pairHash(1, clash, 0) & mask) !=
+            (plateCollisions::pairHash(1, 0, 0) & mask)) {
+        ++clash;
+    }
+
+    plateCollisions records;
+    records.add(0, 1, 0, 0, 1.0f, 0, 0);       // 0: pair A
+    records.add(2, 0, 0, 0, 2.0f, 3, 5);       // 1: pair E of plate 2
+    records.add(0, 1, 0, 0, 4.0f, clash, 0);   // 2: pair B, same slot as A
+    records.add(0, 2, 0, 0, 8.0f, 0, 0);       // 3: pair C, continent of A
+    records.add(0, 1, 0, 0, 16.0f, 0, 0);      // 4: pair A
+    records.add(2, 0, 0, 0, 32.0f, 3, 5);      // 5: pair E
+    records.add(0, 1, 0, 0, 64.0f, clash, 0);  // 6: pair B
+    records.add(0, 1, 0, 0, 128.0f, 0, 1);     // 7: pair D, continent of A
+
+    // Plate 1 has no records.
+    records.sumByContinents(3);
+
+    EXPECT_EQ(vector<uint32_t>({0, 2, 3, 7, 1}), records.pair_first);
+    EXPECT_EQ(vector<float>({17.0f, 68.0f, 8.0f, 128.0f, 34.0f}), records.pair_crust);
+
+    // clear() only forgets the records: sumByContinents() starts its pairs
+    // over, so none of the earlier step are left.
+    records.clear();
+    records.add(1, 0, 0, 0, 1.0f, 0, 0);
+    records.sumByContinents(3);
+    EXPECT_EQ(vector<uint32_t>({0}), records.pair_first);
+    EXPECT_EQ(vector<float>({1.0f}), records.pair_crust);
+}
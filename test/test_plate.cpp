@@ -18,7 +18,12 @@
  *****************************************************************************/
 
 #include "plate.hpp"
+#include "plate_functions.hpp"
+#include "lithosphere.hpp" // CONTINENTAL_BASE
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include "noise.hpp"
 #include "simplexnoise.hpp"
 
@@ -45,6 +50,40 @@ TEST(SimpleRandom, NextRepeatability)
     EXPECT_EQ(3364058674, sr999.next());
 }
 
+TEST(Utils, QuantileMatchesPlainBisection)
+{
+    SimpleRandom random(3);
+    const uint32_t size = 5000;
+    vector<float> values(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        // Mostly in [0, 1], some out of it and some on the bin edges.
+        values[i] = i % 97 == 0 ? (i % 2 ? 1.0f : -0.25f) :
+                    i % 13 == 0 ? (i % 64) / 64.0f :
+                    static_cast<float>(random.next_double() * 1.2 - 0.1);
+    }
+
+    const float precisions[] = { 0.01f, 0.00001f };
+    const float quantiles[] = { 0.0f, 0.15f, 0.5f, 0.65f, 0.99f, 1.0f };
+    for (float precision : precisions) {
+        for (float quantile : quantiles) {
+            float expected = 0.5f;
+            float th_step = 0.5f;
+            while (th_step > precision) {
+                uint32_t count = 0;
+                for (uint32_t i = 0; i < size; ++i)
+                    count += (values[i] < expected);
+                th_step *= 0.5f;
+                if (count / (float)size < quantile)
+                    expected += th_step;
+                else
+                    expected -= th_step;
+            }
+            EXPECT_EQ(expected, find_value_for_quantile(quantile, values.data(), size, precision))
+                    << "quantile " << quantile << " precision " << precision;
+        }
+    }
+}
+
 TEST(Noise, SimplexRawNoiseRepeatability)
 {
     EXPECT_FLOAT_EQ(-0.12851511f, raw_noise_4d(0.3f, 0.78f, 1.677f, 0.99f));
@@ -54,6 +93,67 @@ TEST(Noise, SimplexRawNoiseRepeatability)
     EXPECT_FLOAT_EQ(-0.063593678f, raw_noise_4d(0.3f, 500.78f, 1.677f, 500.99f));
 }
 
+TEST(Noise, BatchRawNoiseIsBitIdentical)
+{
+    // 8 points at a time plus a tail, with integer coordinates where
+    // fastfloor() is at its edge.
+    SimpleRandom random(11);
+    const uint32_t count = 203;
+    vector<float> x(count), y(count), z(count), w(count), out(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float scale = i % 3 == 0 ? 1000.0f : 4.0f;
+        x[i] = scale * static_cast<float>(random.next_double() - 0.5);
+        y[i] = scale * static_cast<float>(random.next_double() - 0.5);
+        z[i] = i % 5 == 0 ? static_cast<float>(i % 7) - 3.0f : static_cast<float>(random.next_double());
+        w[i] = i % 11 == 0 ? 0.0f : 300.0f * static_cast<float>(random.next_double());
+    }
+
+    raw_noise_4d(x.data(), y.data(), z.data(), w.data(), out.data(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float expected = raw_noise_4d(x[i], y[i], z[i], w[i]);
+        ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float))) << "point " << i;
+    }
+
+    raw_noise_2d(x.data(), y.data(), out.data(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float expected = raw_noise_2d(x[i], y[i]);
+        ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float))) << "point " << i;
+    }
+
+    raw_noise_3d(x.data(), y.data(), z.data(), out.data(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float expected = raw_noise_3d(x[i], y[i], z[i]);
+        ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float))) << "point " << i;
+    }
+
+    scaled_octave_noise_3d(4.0f, 0.25f, 0.25f, 0.0f, 1.0f,
+                           x.data(), y.data(), z.data(), out.data(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float expected = scaled_octave_noise_3d(4.0f, 0.25f, 0.25f, 0.0f, 1.0f,
+                                                      x[i], y[i], z[i]);
+        ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float))) << "point " << i;
+    }
+
+    scaled_octave_noise_4d(4.0f, 0.25f, 0.25f, 0.0f, 1.0f,
+                           x.data(), y.data(), z.data(), w.data(), out.data(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float expected = scaled_octave_noise_4d(4.0f, 0.25f, 0.25f, 0.0f, 1.0f,
+                                                      x[i], y[i], z[i], w[i]);
+        ASSERT_EQ(0, memcmp(&expected, &out[i], sizeof(float))) << "point " << i;
+    }
+}
+
+TEST(Noise, SlowNoiseDoesNotDependOnThreads)
+{
+    const WorldDimension wd(129, 77);
+    vector<float> serial(wd.getArea()), threaded(wd.getArea());
+    createSlowNoise(serial.data(), wd, SimpleRandom(5));
+    ThreadPool pool(3);
+    createSlowNoise(threaded.data(), wd, SimpleRandom(5), &pool);
+
+    EXPECT_EQ(0, memcmp(serial.data(), threaded.data(), wd.getArea() * sizeof(float)));
+}
+
 TEST(Noise, SimplexNoiseRepeatability)
 {
     WorldDimension wd(233, 111);
@@ -126,6 +226,113 @@ TEST(Plate, calculateCrust)
     EXPECT_EQ(250, s);
 }
 
+// Continent ids of every point of a side x side plate in a world as wide
+// and tall as world, from flood fills on lookup or from union-find.
+static vector<ContinentId> segmentIds(const HeightMap& map, uint32_t side,
+                                      const WorldDimension& world, Segmentation segmentation,
+                                      vector<uint32_t>* areas)
+{
+    HeightMap copy(map);
+    Bounds bounds(world, FloatPoint(0.0f, 0.0f), Dimension(side, side));
+    Segments segments(side * side);
+    MySegmentCreator creator(bounds, &segments, copy, world);
+    segments.setSegmentCreator(&creator);
+    segments.setBounds(&bounds);
+
+    segments.reset();
+    if (segmentation == SEGMENTS_UNION_FIND) {
+        creator.createAllSegments();
+    }
+    vector<ContinentId> ids(side * side, static_cast<ContinentId>(-1));
+    for (uint32_t y = 0, i = 0; y < side; ++y) {
+        for (uint32_t x = 0; x < side; ++x, ++i) {
+            if (copy[i] >= CONT_BASE) {
+                ids[i] = segments.getContinentAt(x, y);
+            }
+        }
+    }
+    for (uint32_t s = 0; s < segments.size(); ++s) {
+        areas->push_back(segments[s].area());
+    }
+    return ids;
+}
+
+TEST(Segments, UnionFindFindsTheContinentsOfFloodFill)
+{
+    const uint32_t side = 64;
+    const WorldDimension world(2 * side, 2 * side);
+    HeightMap map(side, side);
+    initializeHeightmapWithNoise(4, map.raw_data(), WorldDimension(side, side));
+    for (uint32_t i = 0; i < side * side; ++i) {
+        map[i] = map[i] > 0.5f ? 1.5f : 0.1f;
+    }
+
+    vector<uint32_t> lazy_areas, eager_areas;
+    const vector<ContinentId> lazy = segmentIds(map, side, world, SEGMENTS_LAZY_FLOOD, &lazy_areas);
+    const vector<ContinentId> eager = segmentIds(map, side, world, SEGMENTS_UNION_FIND, &eager_areas);
+
+    // The same partition of the continental points, numbered alike.
+    ASSERT_EQ(lazy_areas.size(), eager_areas.size());
+    ASSERT_GT(eager_areas.size(), 1u);
+    uint32_t continental = 0;
+    for (uint32_t i = 0; i < side * side; ++i) {
+        continental += map[i] >= CONT_BASE;
+        EXPECT_EQ(lazy[i], eager[i]) << "point " << i;
+    }
+    uint32_t total = 0;
+    for (uint32_t a : eager_areas) {
+        total += a;
+    }
+    EXPECT_EQ(continental, total);
+}
+
+TEST(Segments, UnionFindJoinsContinentsAcrossTheWorldEdge)
+{
+    const uint32_t side = 8;
+    const WorldDimension world(side, side);
+    HeightMap map(side, side);
+    map.set_all(0.1f);
+    for (uint32_t y = 2; y < 4; ++y) {
+        map.set(0, y, 1.5f);
+        map.set(side - 1, y, 1.5f);
+    }
+
+    vector<uint32_t> areas;
+    const vector<ContinentId> ids = segmentIds(map, side, world, SEGMENTS_UNION_FIND, &areas);
+    ASSERT_EQ(1u, areas.size());
+    EXPECT_EQ(4u, areas[0]);
+    EXPECT_EQ(0u, ids[2 * side + side - 1]);
+}
+
+TEST(Plate, ResetSegmentsKeepsThemWhileTheContinentsStay)
+{
+    // An 8 x 4 plate whose three left columns are one continent.
+    float *heightmap = new float[8 * 4];
+    for (uint32_t i = 0; i < 8 * 4; ++i) {
+        heightmap[i] = i % 8 < 3 ? 1.5f : 0.1f;
+    }
+    plate p(1, heightmap, 8, 4, 2, 2, 0, WorldDimension(16, 16));
+    p.labelSegments();
+    EXPECT_EQ(12u, p.addCollision(2, 2));
+
+    uint32_t count;
+    float ratio;
+    p.getCollisionInfo(2, 2, &count, &ratio);
+    EXPECT_EQ(1u, count);
+
+    // Oceanic crust changes, the continent stays: only the count is cleared.
+    p.setCrust(8, 3, 0.5f, 0);
+    p.labelSegments();
+    p.getCollisionInfo(2, 2, &count, &ratio);
+    EXPECT_EQ(0u, count);
+    EXPECT_EQ(12u, p.getContinentArea(2, 2));
+
+    // A new continental point next to it is found after the next reset.
+    p.setCrust(5, 2, 1.5f, 0);
+    p.labelSegments();
+    EXPECT_EQ(13u, p.getContinentArea(2, 2));
+}
+
 class MockSegmentData : public ISegmentData
 {
 public:
@@ -137,6 +344,9 @@ public:
     virtual void incCollCount() {
         _collCount++;
     }
+    virtual void resetCollCount() {
+        _collCount = 0;
+    }
     virtual void incArea() {
         _area++;
     }
@@ -194,7 +404,8 @@ public:
     virtual void reset() {
         throw runtime_error("Not implemented");
     }
-    virtual void reassign(uint32_t newarea, uint32_t* tmps) {
+    virtual void grow(uint32_t old_width, uint32_t width, uint32_t height,
+                      uint32_t d_lft, uint32_t d_top) {
         throw runtime_error("Not implemented");
     }
     virtual void shift(uint32_t d_lft, uint32_t d_top) {
@@ -217,7 +428,7 @@ public:
             throw runtime_error("(MockSegments::operator[]) Unexpected call");
         }
     }
-    virtual void add(ISegmentData* data) {
+    virtual void add(const SegmentData& data) {
         throw runtime_error("Not implemented");
     }
     virtual const ContinentId& id(uint32_t index) const {
@@ -272,8 +483,9 @@ public:
     virtual void reset() {
         throw runtime_error("(MockSegments2::reset) Not implemented");
     }
-    virtual void reassign(uint32_t newarea, uint32_t* tmps) {
-        throw runtime_error("(MockSegments2::reassign) Not implemented");
+    virtual void grow(uint32_t old_width, uint32_t width, uint32_t height,
+                      uint32_t d_lft, uint32_t d_top) {
+        throw runtime_error("(MockSegments2::grow) Not implemented");
     }
     virtual void shift(uint32_t d_lft, uint32_t d_top) {
         throw runtime_error("(MockSegments2::shift) Not implemented");
@@ -296,7 +508,7 @@ public:
                                        + Platec::to_string(id)));
         }
     }
-    virtual void add(ISegmentData* data) {
+    virtual void add(const SegmentData& data) {
         throw runtime_error("(MockSegments2::add) Not implemented");
     }
     virtual const ContinentId& id(uint32_t index) const {
@@ -444,6 +656,252 @@ TEST(Plate, addCrustBySubduction)
     ASSERT_EQ(true, timestampIn_240_120after < 123 );
 }
 
+// The redistribution pass of plate::erode as it was written originally:
+// point by point, scattering into the neighbours.
+static void redistributeCrustReference(const HeightMap& map, float lower_bound,
+                                       const WorldDimension& wd, HeightMap& tmpHm)
+{
+    HeightMap heights(map);
+    const uint32_t width = map.width();
+    const uint32_t height = map.height();
+    tmpHm.set_all(0.0f);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint32_t index = y * width + x;
+            tmpHm[index] += heights[index];
+            if (heights[index] < lower_bound)
+                continue;
+
+            float w_crust, e_crust, n_crust, s_crust;
+            uint32_t w, e, n, s;
+            calculateCrust(x, y, index, w_crust, e_crust, n_crust, s_crust,
+                           w, e, n, s, wd, heights, width, height);
+            if (w_crust + e_crust + n_crust + s_crust == 0)
+                continue;
+
+            float w_diff = heights[index] - w_crust;
+            float e_diff = heights[index] - e_crust;
+            float n_diff = heights[index] - n_crust;
+            float s_diff = heights[index] - s_crust;
+
+            float min_diff = w_diff;
+            min_diff -= (min_diff - e_diff) * (e_diff < min_diff);
+            min_diff -= (min_diff - n_diff) * (n_diff < min_diff);
+            min_diff -= (min_diff - s_diff) * (s_diff < min_diff);
+
+            float diff_sum = (w_diff - min_diff) * (w_crust > 0) +
+                             (e_diff - min_diff) * (e_crust > 0) +
+                             (n_diff - min_diff) * (n_crust > 0) +
+                             (s_diff - min_diff) * (s_crust > 0);
+
+            if (diff_sum < min_diff) {
+                tmpHm[w] += (w_diff - min_diff) * (w_crust > 0);
+                tmpHm[e] += (e_diff - min_diff) * (e_crust > 0);
+                tmpHm[n] += (n_diff - min_diff) * (n_crust > 0);
+                tmpHm[s] += (s_diff - min_diff) * (s_crust > 0);
+                tmpHm[index] -= min_diff;
+
+                min_diff -= diff_sum;
+                min_diff /= 1 + (w_crust > 0) + (e_crust > 0) +
+                            (n_crust > 0) + (s_crust > 0);
+
+                tmpHm[w] += min_diff * (w_crust > 0);
+                tmpHm[e] += min_diff * (e_crust > 0);
+                tmpHm[n] += min_diff * (n_crust > 0);
+                tmpHm[s] += min_diff * (s_crust > 0);
+                tmpHm[index] += min_diff;
+            } else {
+                float unit = min_diff / diff_sum;
+                tmpHm[index] -= min_diff;
+                tmpHm[w] += unit * (w_diff - min_diff) * (w_crust > 0);
+                tmpHm[e] += unit * (e_diff - min_diff) * (e_crust > 0);
+                tmpHm[n] += unit * (n_diff - min_diff) * (n_crust > 0);
+                tmpHm[s] += unit * (s_diff - min_diff) * (s_crust > 0);
+            }
+        }
+    }
+}
+
+// Compare redistributeCrust with the reference on a random plate of the
+// given size in the given world; the plate wraps where it is as large as
+// the world.
+static void checkRedistribution(uint32_t width, uint32_t height,
+                                const WorldDimension& wd)
+{
+    SimpleRandom random(width * 31 + height);
+    HeightMap map(width, height);
+    for (uint32_t i = 0; i < map.area(); ++i) {
+        map[i] = 3.0f * static_cast<float>(random.next_double());
+    }
+
+    HeightMap expected(width, height);
+    redistributeCrustReference(map, CONTINENTAL_BASE, wd, expected);
+
+    PaddedMatrix<float> padded;
+    const bool wrap_x = width == wd.getWidth();
+    const bool wrap_y = height == wd.getHeight();
+    padded.assign(map, wrap_x, wrap_y, FLT_MAX);
+    HeightMap actual(width, height);
+    redistributeCrust(padded, CONTINENTAL_BASE, wrap_x, wrap_y, actual.raw_data());
+
+    // The tolerance documented by redistributeCrust.
+    for (uint32_t i = 0; i < map.area(); ++i) {
+        ASSERT_NEAR(expected[i], actual[i], std::ldexp(std::max(map[i], 1.0f), -20))
+                << "at " << i % width << "," << i / width;
+    }
+}
+
+TEST(ErodeRedistribution, MatchesScatterWithinTolerance)
+{
+    checkRedistribution(100, 70, WorldDimension(256, 128));
+}
+
+TEST(ErodeRedistribution, MatchesScatterOnWrappingPlate)
+{
+    checkRedistribution(64, 48, WorldDimension(64, 48));
+    checkRedistribution(64, 48, WorldDimension(64, 128));
+    checkRedistribution(64, 48, WorldDimension(128, 48));
+}
+
+TEST(ErodeRedistribution, MatchesScatterOnThinPlates)
+{
+    checkRedistribution(1, 40, WorldDimension(64, 64));
+    checkRedistribution(40, 1, WorldDimension(64, 64));
+    checkRedistribution(40, 1, WorldDimension(40, 1));
+}
+
+// A valley between two walls, in a world as large as the plate: from the
+// peak at x = 6 the valley goes down to a pit at x = 2, then over x = 1
+// to the sea at x = 0.
+static HeightMap valleyMap()
+{
+    const float valley[8] = { 0.5f, 2.0f, 1.5f, 3.0f, 5.0f, 7.0f, 8.5f, 8.2f };
+    HeightMap map(8, 3);
+    map.set_all(8.0f);
+    for (uint32_t x = 0; x < 8; ++x) {
+        map.set(x, 1, valley[x]);
+    }
+    return map;
+}
+
+TEST(FloodRivers, RiversCrossPitsToTheSea)
+{
+    const HeightMap map = valleyMap();
+    const vector<uint32_t> sources(1, 1 * 8 + 6);
+    vector<uint32_t> upstream;
+    FloodScratch scratch;
+
+    floodRivers(map, CONTINENTAL_BASE, true, true, sources, upstream, scratch);
+
+    ASSERT_EQ(map.area(), upstream.size());
+    for (uint32_t y = 0; y < 3; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            const uint32_t expected = y == 1 && x <= 6 ? 1 : 0;
+            EXPECT_EQ(expected, upstream[y * 8 + x]) << "at " << x << "," << y;
+        }
+    }
+}
+
+TEST(FloodRivers, UpstreamSourcesAddUp)
+{
+    // A second source on the wall above the pit joins the river there.
+    HeightMap map = valleyMap();
+    map.set(2, 0, 9.0f);
+    const vector<uint32_t> sources = { 1 * 8 + 6, 0 * 8 + 2 };
+    vector<uint32_t> upstream;
+    FloodScratch scratch;
+
+    floodRivers(map, CONTINENTAL_BASE, true, true, sources, upstream, scratch);
+
+    EXPECT_EQ(1u, upstream[0 * 8 + 2]);
+    EXPECT_EQ(1u, upstream[1 * 8 + 3]);
+    EXPECT_EQ(2u, upstream[1 * 8 + 1]);
+    EXPECT_EQ(2u, upstream[1 * 8 + 0]);
+}
+
+TEST(FloodRivers, EdgesOfNonWrappingPlatesAreOutlets)
+{
+    // No sea at all: the peak drains over the edge, ties between equally
+    // low neighbours go to the first one in memory order.
+    HeightMap map(3, 3);
+    map.set_all(5.0f);
+    map.set(1, 1, 9.0f);
+    const vector<uint32_t> sources(1, 4);
+    vector<uint32_t> upstream;
+    FloodScratch scratch;
+
+    floodRivers(map, CONTINENTAL_BASE, false, false, sources, upstream, scratch);
+
+    const uint32_t expected[9] = { 0, 1, 0, 0, 1, 0, 0, 0, 0 };
+    for (uint32_t i = 0; i < 9; ++i) {
+        EXPECT_EQ(expected[i], upstream[i]) << "at " << i;
+    }
+}
+
+static HeightMap smoothed(const HeightMap& map, bool wrap)
+{
+    PaddedMatrix<float> padded;
+    padded.assign(map, wrap, wrap, FLT_MAX);
+    HeightMap out(map.width(), map.height());
+    smoothCrust(padded, CONTINENTAL_BASE, 0.1f, 0.5f, out.raw_data());
+    return out;
+}
+
+TEST(SmoothCrust, SteepSlopesSlideDown)
+{
+    HeightMap map(3, 3);
+    map.set_all(2.0f);
+    map.set(1, 1, 3.0f);
+
+    const HeightMap out = smoothed(map, false);
+
+    // Each side gets 0.5 / 4 of the excess slope 1.0 - 0.1.
+    const float share = 0.125f * 0.9f;
+    EXPECT_FLOAT_EQ(3.0f - 4 * share, out.get(1, 1));
+    EXPECT_FLOAT_EQ(2.0f + share, out.get(1, 0));
+    EXPECT_FLOAT_EQ(2.0f + share, out.get(0, 1));
+    EXPECT_FLOAT_EQ(2.0f, out.get(0, 0));
+}
+
+TEST(SmoothCrust, GentleSlopesAndLowCrustStay)
+{
+    HeightMap map(4, 1);
+    const float heights[4] = { 2.0f, 2.05f, 0.5f, 0.1f };
+    for (uint32_t x = 0; x < 4; ++x) {
+        map.set(x, 0, heights[x]);
+    }
+
+    const HeightMap out = smoothed(map, false);
+
+    EXPECT_FLOAT_EQ(2.0f, out.get(0, 0));
+    EXPECT_LT(out.get(1, 0), 2.05f); // Slides to the sea, not to x = 0.
+    EXPECT_GT(out.get(2, 0), 0.5f);
+    EXPECT_FLOAT_EQ(0.1f, out.get(3, 0)); // 0.5 is below the bound.
+}
+
+TEST(SmoothCrust, ConservesCrust)
+{
+    for (int wrap = 0; wrap < 2; ++wrap) {
+        SimpleRandom random(17);
+        HeightMap map(37, 23);
+        double before = 0;
+        for (uint32_t i = 0; i < map.area(); ++i) {
+            map[i] = 3.0f * static_cast<float>(random.next_double());
+            before += map[i];
+        }
+
+        const HeightMap out = smoothed(map, wrap != 0);
+
+        double after = 0;
+        for (uint32_t i = 0; i < out.area(); ++i) {
+            EXPECT_GE(out[i], 0.0f);
+            after += out[i];
+        }
+        EXPECT_NEAR(before, after, 1e-3) << "wrap " << wrap;
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -20,3 +20,58 @@
 #include "sqrdmd.hpp"
 #include <cstdio>
 #include "gtest/gtest.h"
+#include <cstring>
+#include <vector>
+#include "noise.hpp"
+
+using namespace std;
+
+TEST(Sqrdmd, HashedDoesNotDependOnThreads)
+{
+    const int size = 129;
+    vector<float> serial(size * size), threaded(size * size);
+    sqrdmd_hashed(7, serial.data(), size, 0.35f);
+    ThreadPool pool(4);
+    sqrdmd_hashed(7, threaded.data(), size, 0.35f, &pool);
+
+    EXPECT_EQ(0, memcmp(serial.data(), threaded.data(), serial.size() * sizeof(float)));
+}
+
+TEST(Sqrdmd, HashedFillsAndWrapsTheMap)
+{
+    const int size = 65;
+    vector<float> map(size * size, 0.0f);
+    map[0] = map[size - 1] = map[(size - 1) * size] = map[size * size - 1] = 0.5f;
+    sqrdmd_hashed(3, map.data(), size, 0.35f);
+
+    uint32_t zeros = 0;
+    for (int i = 0; i < size * size; ++i) {
+        zeros += map[i] == 0.0f;
+    }
+    EXPECT_EQ(0u, zeros);
+    for (int i = 0; i < size; ++i) {
+        EXPECT_EQ(map[i], map[(size - 1) * size + i]) << "column " << i;
+        EXPECT_EQ(map[i * size], map[i * size + size - 1]) << "row " << i;
+    }
+}
+
+TEST(Sqrdmd, HashedKeepsPointsThatAreSet)
+{
+    const int size = 33;
+    vector<float> map(size * size, 0.0f);
+    map[10 * size + 7] = 5.0f;
+    sqrdmd_hashed(3, map.data(), size, 0.35f);
+
+    EXPECT_EQ(5.0f, map[10 * size + 7]);
+}
+
+TEST(Sqrdmd, HashedNoiseDoesNotDependOnThreads)
+{
+    const WorldDimension wd(100, 70);
+    vector<float> serial(wd.getArea(), 0.0f), threaded(wd.getArea(), 0.0f);
+    createNoise(serial.data(), wd, SimpleRandom(5), NOISE_SQRDMD_HASHED);
+    ThreadPool pool(3);
+    createNoise(threaded.data(), wd, SimpleRandom(5), NOISE_SQRDMD_HASHED, &pool);
+
+    EXPECT_EQ(0, memcmp(serial.data(), threaded.data(), wd.getArea() * sizeof(float)));
+}
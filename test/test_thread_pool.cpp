@@ -0,0 +1,71 @@
+/******************************************************************************
+ *  plate-tectonics, a plate tectonics simulation library
+ *  Copyright (C) 2012-2013 Lauri Viitanen
+ *  Copyright (C) 2014-2015 Federico Tomassetti, Bret Curtis
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, see http://www.gnu.org/licenses/
+ *****************************************************************************/
+
+#include "thread_pool.hpp"
+#include "gtest/gtest.h"
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPool, Size)
+{
+    EXPECT_EQ(1u, ThreadPool(1).size());
+    EXPECT_EQ(4u, ThreadPool(4).size());
+    EXPECT_LE(1u, ThreadPool(0).size());
+}
+
+TEST(ThreadPool, RunsEveryIterationOnce)
+{
+    ThreadPool pool(4);
+    for (uint32_t count = 0; count < 50; count += 7) {
+        std::vector<int> runs(count, 0);
+        pool.parallelFor(count, [&runs](uint32_t i) {
+            ++runs[i];
+        });
+        for (uint32_t i = 0; i < count; ++i) {
+            EXPECT_EQ(1, runs[i]);
+        }
+    }
+}
+
+TEST(ThreadPool, SingleThreadRunsInOrder)
+{
+    ThreadPool pool(1);
+    std::vector<uint32_t> order;
+    pool.parallelFor(5, [&order](uint32_t i) {
+        order.push_back(i);
+    });
+    EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3, 4}), order);
+}
+
+TEST(ThreadPool, RethrowsTaskException)
+{
+    ThreadPool pool(3);
+    EXPECT_THROW(pool.parallelFor(10, [](uint32_t i) {
+        if (i == 7) {
+            throw std::runtime_error("failed");
+        }
+    }), std::runtime_error);
+
+    // The pool is still usable afterwards.
+    std::vector<int> runs(10, 0);
+    pool.parallelFor(10, [&runs](uint32_t i) {
+        ++runs[i];
+    });
+    EXPECT_EQ(std::vector<int>(10, 1), runs);
+}